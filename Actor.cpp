@@ -1,10 +1,18 @@
 #include "Actor.h"
 #include "StudentWorld.h"
+#include "Snapshot.h"
 
 Actor::Actor(StudentWorld* world, int imageID, int startX, int startY, int startDirection = none)
-	: GraphObject(imageID, startX, startY, startDirection), m_world(world), m_alive(true)
+	: GraphObject(imageID, startX, startY, startDirection), m_world(world), m_type(imageID), m_alive(true), m_nextInCell(nullptr), m_spawnOrder(0), m_cellFlags(0), m_static(false), m_woken(false)
 {}
 
+void Actor::moveTo(double x, double y) {
+    int oldX = getX();
+    int oldY = getY();
+    GraphObject::moveTo(x, y);
+    m_world->updateActorLocation(this, oldX, oldY);
+}
+
 bool Actor::isAlive() const{
 	if (!m_alive) {
 		return false;
@@ -24,8 +32,27 @@ StudentWorld* Actor::getWorld() const {
 }
 
 void Actor::kill() {
-    m_alive = false;
+    if (m_alive) {
+        m_alive = false;
+        m_world->actorDied(this);
+    }
     setVisible(false);
+    m_world->updateCellFlags(this);
+}
+
+// Direction and visibility share a byte: the direction as 0 for none or 1 + quarter turns, shifted past the visibility bit
+void Actor::saveState(SnapshotWriter& out) const {
+    int dir = getDirection();
+    int dirCode = (dir == none ? 0 : dir / 90 + 1);
+    out.putByte((dirCode << 1) | (isVisible() ? 1 : 0));
+}
+
+void Actor::restoreState(SnapshotReader& in) {
+    unsigned int b = in.getByte();
+    int dirCode = b >> 1;
+    if (dirCode != 0) // every actor made facing none still faces none
+        setDirection((dirCode - 1) * 90);
+    setVisible((b & 1) != 0);
 }
 
 // AGENT IMPLEMENTATIONS
@@ -47,6 +74,55 @@ void Agent::restorePlayerHitPoints() {
     m_hitpoints = 20;
 }
 
+void Agent::saveState(SnapshotWriter& out) const {
+    Actor::saveState(out);
+    out.putInt(m_hitpoints);
+}
+
+void Agent::restoreState(SnapshotReader& in) {
+    Actor::restoreState(in);
+    m_hitpoints = in.getInt();
+}
+
+// The hot paths call the agents' hooks directly, picked by the type tag, as StudentWorld
+// ticks actors; the VIRTUAL_TICKS reference path makes the virtual calls instead
+static bool usesVirtualHooks(const Actor* actor) {
+    return actor->getWorld()->usesReferencePath(StudentWorld::VIRTUAL_TICKS);
+}
+
+static bool agentNeedsClearShot(const Agent* agent) {
+    if (usesVirtualHooks(agent))
+        return agent->needsClearShot();
+    if (agent->getType() == IID_PLAYER)
+        return static_cast<const Player*>(agent)->Player::needsClearShot();
+    return static_cast<const Robot*>(agent)->Robot::needsClearShot();
+}
+
+static int agentShootingSound(const Agent* agent) {
+    if (usesVirtualHooks(agent))
+        return agent->shootingSound();
+    if (agent->getType() == IID_PLAYER)
+        return static_cast<const Player*>(agent)->Player::shootingSound();
+    return static_cast<const Robot*>(agent)->Robot::shootingSound();
+}
+
+static bool robotShoots(const Robot* robot) {
+    if (usesVirtualHooks(robot))
+        return robot->isShootingRobot();
+    if (robot->getType() == IID_THIEFBOT)
+        return static_cast<const RegularThiefBot*>(robot)->RegularThiefBot::isShootingRobot();
+    return robot->Robot::isShootingRobot();
+}
+
+static void robotPerformAction(Robot* robot) {
+    if (usesVirtualHooks(robot))
+        robot->performAction();
+    else if (robot->getType() == IID_RAGEBOT)
+        static_cast<RageBot*>(robot)->RageBot::performAction();
+    else
+        static_cast<ThiefBot*>(robot)->ThiefBot::performAction();
+}
+
 bool Agent::firePea() {
     int x = getX();
     int y = getY();
@@ -65,17 +141,17 @@ bool Agent::firePea() {
             break;
     }
 
-    if (needsClearShot()) { // robot
+    if (agentNeedsClearShot(this)) { // robot
         if (shotIsClear()) {
             getWorld()->createNewPea(x, y, getDirection());
-            getWorld()->playSound(shootingSound());
+            getWorld()->playSound(agentShootingSound(this));
             return true;
         }
     }
     else { // player
         getWorld()->createNewPea(x, y, getDirection());
         getWorld()->getPlayer()->decreaseAmmo(1);
-        getWorld()->playSound(shootingSound());
+        getWorld()->playSound(agentShootingSound(this));
         return true;
     }
     return false;
@@ -87,34 +163,36 @@ bool Agent::shotIsClear() {
     int x = getX();
     int y = getY();
 
+    // the player has to be straight ahead of us before it's worth tracing the shot
+    int distanceToPlayer;
     switch (getDirection()) {
     case up:
-        y++;
-        while (getWorld()->isObstacleAt(x, y) == false && isWithinBounds(x, y)) {
-            y++;
-        }
+        if (playerX != x || playerY <= y)
+            return false;
+        distanceToPlayer = playerY - y;
         break;
     case down:
-        y--;
-        while (getWorld()->isObstacleAt(x, y) == false && isWithinBounds(x, y)) {
-            y--;
-        }
+        if (playerX != x || playerY >= y)
+            return false;
+        distanceToPlayer = y - playerY;
         break;
     case left:
-        x--;
-        while (getWorld()->isObstacleAt(x, y) == false && isWithinBounds(x, y)) {
-            x--;
-        }
+        if (playerY != y || playerX >= x)
+            return false;
+        distanceToPlayer = x - playerX;
         break;
     case right:
-        x++;
-        while (getWorld()->isObstacleAt(x, y) == false && isWithinBounds(x, y)) {
-            x++;
-        }
+        if (playerY != y || playerX <= x)
+            return false;
+        distanceToPlayer = playerX - x;
         break;
+    default:
+        return false;
     }
 
-    if (x == playerX && y == playerY) {
+    // clear unless an obstacle sits between us and the player
+    int distanceToObstacle = getWorld()->distanceToObstacle(x, y, getDirection());
+    if (distanceToObstacle == -1 || distanceToObstacle >= distanceToPlayer) {
         return true;
     }
     return false;
@@ -197,6 +275,16 @@ void Player::increaseAmmo(int amount) {
     m_ammo += amount;
 }
 
+void Player::saveState(SnapshotWriter& out) const {
+    Agent::saveState(out);
+    out.putInt(m_ammo);
+}
+
+void Player::restoreState(SnapshotReader& in) {
+    Agent::restoreState(in);
+    m_ammo = in.getInt();
+}
+
 void Player::damage(int damageAmt) {
     decreaseHitPoints(damageAmt);
     getWorld()->playSound(SOUND_PLAYER_IMPACT);
@@ -264,13 +352,13 @@ void Robot::doSomething() {
     if (m_ticks / ticks == 1) {
         m_ticks = 0;
 
-        if (isShootingRobot() && needsClearShot()) {
+        if (robotShoots(this)) {
             if (firePea()) { // returns true if pea fired
                 return;
             }
         }
 
-        performAction();
+        robotPerformAction(this);
     }
 }
 
@@ -278,6 +366,16 @@ int Robot::getScoreValue() const {
     return m_scoreValue;
 }
 
+void Robot::saveState(SnapshotWriter& out) const {
+    Agent::saveState(out);
+    out.putInt(m_ticks);
+}
+
+void Robot::restoreState(SnapshotReader& in) {
+    Agent::restoreState(in);
+    m_ticks = in.getInt();
+}
+
 // RAGEBOT IMPLEMENTATIONS
 
 RageBot::RageBot(StudentWorld* world, int startX, int startY, int startDir) 
@@ -316,12 +414,12 @@ void RageBot::damage(int damageAmt) {
 // THIEFBOT IMPLEMENTATIONS
 
 ThiefBot::ThiefBot(StudentWorld* world, int imageID, int startX, int startY, int hitPoints, int score) 
-: Robot(world, imageID, startX, startY, hitPoints, score, right), m_distanceBeforeTurning(randInt(1, 6)), m_carryingGoodie(false), m_stolenGoodie(nullptr) {
+: Robot(world, imageID, startX, startY, hitPoints, score, right), m_distanceBeforeTurning(world->randInt(1, 6)), m_carryingGoodie(false), m_stolenGoodie(nullptr) {
 }
 
 void ThiefBot::performAction() {
     if (getWorld()->getGoodieAt(getX(), getY()) != nullptr && !hasPickedUpGoodie()) {
-        int random = randInt(1, 10);
+        int random = getWorld()->randInt(1, 10);
         if (random == 1) { // 1 in 10 chance
             pickUpGoodie();
             return;
@@ -335,9 +433,9 @@ void ThiefBot::performAction() {
         }
     }
 
-    m_distanceBeforeTurning = randInt(1, 6);
+    m_distanceBeforeTurning = getWorld()->randInt(1, 6);
     std::vector<int> attemptedDirections;
-    int randomDir = randInt(1, 4);
+    int randomDir = getWorld()->randInt(1, 4);
     int temp = randomDir;
     for (int i = 0; i < 4; i++) {
         int x = getX();
@@ -383,7 +481,7 @@ void ThiefBot::performAction() {
         if (i < 3) {
             bool isNewDir = false;
             while (!isNewDir) {
-                randomDir = randInt(1, 4);
+                randomDir = getWorld()->randInt(1, 4);
                 bool found = false;
                 for (size_t i = 0; i < attemptedDirections.size(); i++) {
                     if (attemptedDirections[i] == randomDir) {
@@ -445,6 +543,19 @@ void ThiefBot::pickUpGoodie() {
     }
 }
 
+// The stolen goodie is saved by the world, which knows where the goodie is in its snapshot
+void ThiefBot::saveState(SnapshotWriter& out) const {
+    Robot::saveState(out);
+    out.putInt(m_distanceBeforeTurning);
+    out.putBool(m_carryingGoodie);
+}
+
+void ThiefBot::restoreState(SnapshotReader& in) {
+    Robot::restoreState(in);
+    m_distanceBeforeTurning = in.getInt();
+    m_carryingGoodie = in.getBool();
+}
+
 // REGULAR THIEFBOT IMPLEMENTATIONS
 
 RegularThiefBot::RegularThiefBot(StudentWorld* world, int startX, int startY) 
@@ -469,7 +580,7 @@ void ThiefBotFactory::doSomething() {
     int count = getWorld()->countThiefBotsSurroundingFactory(getX(), getY());
 
     if (count < 3 && !getWorld()->isThiefBotAt(getX(), getY())) {
-        int random = randInt(1, 50);
+        int random = getWorld()->randInt(1, 50);
 
         if (random == 1) {
             if (m_type == REGULAR)
@@ -481,6 +592,16 @@ void ThiefBotFactory::doSomething() {
     }
 }
 
+void ThiefBotFactory::saveState(SnapshotWriter& out) const {
+    Actor::saveState(out);
+    out.putByte(m_type);
+}
+
+void ThiefBotFactory::restoreState(SnapshotReader& in) {
+    Actor::restoreState(in);
+    m_type = (in.getByte() == MEAN ? MEAN : REGULAR);
+}
+
 // PEA IMPLEMENTATIONS
 
 Pea::Pea(StudentWorld* world, int startX, int startY, int startDirection)
@@ -538,6 +659,16 @@ bool Pea::checkForActors() {
     return false;
 }
 
+void Pea::saveState(SnapshotWriter& out) const {
+    Actor::saveState(out);
+    out.putBool(m_newPea);
+}
+
+void Pea::restoreState(SnapshotReader& in) {
+    Actor::restoreState(in);
+    m_newPea = in.getBool();
+}
+
 // EXIT IMPLEMENTATIONS
 
 Exit::Exit(StudentWorld* world, int startX, int startY)
@@ -546,15 +677,11 @@ Exit::Exit(StudentWorld* world, int startX, int startY)
 }
 
 void Exit::doSomething() {
-    if (!getWorld()->collectedCrystals())
+    if (!getWorld()->playerReachedExit())
         return;
-    int x = getWorld()->getPlayer()->getX();
-    int y = getWorld()->getPlayer()->getY();
-    if (getX() == x && getY() == y) {
-        getWorld()->playSound(SOUND_FINISHED_LEVEL);
-        getWorld()->increaseScore(2000);
-        getWorld()->increaseScore(getWorld()->getBonus());
-    }
+    getWorld()->playSound(SOUND_FINISHED_LEVEL);
+    getWorld()->increaseScore(2000);
+    getWorld()->increaseScore(getWorld()->getBonus());
 }
 
 // WALL IMPLEMENTATIONS
@@ -577,6 +704,16 @@ void Marble::damage(int damageAmt) {
     }
 }
 
+void Marble::saveState(SnapshotWriter& out) const {
+    Actor::saveState(out);
+    out.putInt(m_hitpoints);
+}
+
+void Marble::restoreState(SnapshotReader& in) {
+    Actor::restoreState(in);
+    m_hitpoints = in.getInt();
+}
+
 bool Marble::bePushedBy(Agent* a, int x, int y) {
     switch (a->getDirection()) {
         case up:
@@ -679,6 +816,19 @@ void Goodie::setStolen(bool status) {
     else
         setVisible(true);
     m_stolen = status;
+    getWorld()->updateCellFlags(this);
+}
+
+void Goodie::saveState(SnapshotWriter& out) const {
+    Item::saveState(out);
+    out.putBool(m_stolen);
+}
+
+// Sets m_stolen directly rather than through setStolen, which would update the cell flags: the
+// goodie may be a reused one still indexed as it was, and the world rebuilds the index and flags afterwards
+void Goodie::restoreState(SnapshotReader& in) {
+    Item::restoreState(in);
+    m_stolen = in.getBool();
 }
 
 // EXTRA LIFE GOODIE IMPLEMENTATION
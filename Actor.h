@@ -5,6 +5,8 @@
 
 class StudentWorld;
 class Agent;
+class SnapshotWriter;
+class SnapshotReader;
 
 class Actor : public GraphObject
 {
@@ -20,15 +22,34 @@ class Actor : public GraphObject
 		virtual bool allowsMarble() const { return false; } // PIT SHOULD BE TRUE (when implemented)
 		virtual bool countsInFactoryCensus() const { return false; }
 		virtual bool isStealable() const { return false; }
+		// Static actors aren't ticked every turn, only on the turn the player or a marble moves onto their square.
+		virtual bool isStatic() const { return false; }
 		virtual void damage(int damageAmt) {}
 		virtual void setStolen(bool status) {}
+		// Moves the actor and keeps the world's per-cell index in sync.
+		virtual void moveTo(double x, double y);
 		bool isAlive() const;
 		bool isWithinBounds(int x, int y) const;
 		StudentWorld* getWorld() const;
+		// The IID_ constant of the actor's concrete class; StudentWorld dispatches ticks on it
+		int getType() const { return m_type; }
+		int getSpawnOrder() const { return m_spawnOrder; }
 		void kill();
+		// Write (or read back) everything about the actor that its type and position don't determine.
+		// restoreState may get a freshly constructed actor or a reused one still linked where it was;
+		// either way the world rebuilds its cell index and flags afterwards, so it must not touch them.
+		virtual void saveState(SnapshotWriter& out) const;
+		virtual void restoreState(SnapshotReader& in);
 	private:
+		friend class StudentWorld; // maintains the per-cell occupant links below
 		StudentWorld* m_world;
+		int m_type;
 		bool m_alive;
+		Actor* m_nextInCell; // next occupant of the same cell, in spawn order
+		int m_spawnOrder; // position in the world's spawn sequence
+		int m_cellFlags; // cached StudentWorld::CellFlag bits this actor contributes to its cell
+		bool m_static; // cached isStatic()
+		bool m_woken; // static actor queued to be ticked this turn
 };
 
 class Agent : public Actor
@@ -50,21 +71,22 @@ public:
 	// player).
 	virtual bool canPushMarbles() const { return false; }
 	
-	// Return true if this agent doesn't shoot unless there's an unobstructed
-	// path to the player.
-	//virtual bool needsClearShot() const;
-
 	virtual bool isDestroyable() const { return true; }
 
 	bool firePea();
 
 	bool shotIsClear();
 
+	// Return true if this agent doesn't shoot unless there's an unobstructed
+	// path to the player.  Only the player doesn't.
 	virtual bool needsClearShot() const = 0;
 
 	// Return the sound effect ID for a shot from this agent.
 	virtual int shootingSound() const = 0;
 
+	virtual void saveState(SnapshotWriter& out) const;
+	virtual void restoreState(SnapshotReader& in);
+
 private:
 	int m_hitpoints;
 };
@@ -82,6 +104,8 @@ class Player : public Agent
 		virtual void doSomething();
 		virtual bool needsClearShot() const { return false; }
 		virtual int shootingSound() const { return SOUND_PLAYER_FIRE; }
+		virtual void saveState(SnapshotWriter& out) const;
+		virtual void restoreState(SnapshotReader& in);
 
 	private:
 		int m_ammo;
@@ -97,6 +121,8 @@ public:
 	virtual int shootingSound() const { return SOUND_ENEMY_FIRE; }
 	virtual bool isShootingRobot() const { return true; }
 	int getScoreValue() const;
+	virtual void saveState(SnapshotWriter& out) const;
+	virtual void restoreState(SnapshotReader& in);
 private:
 	int m_scoreValue;
 	int m_ticks;
@@ -120,6 +146,10 @@ public:
 	bool hasPickedUpGoodie() const;
 	bool hasNotMovedDistanceBeforeTurning() const;
 	void pickUpGoodie();
+	Actor* getStolenGoodie() const { return m_stolenGoodie; }
+	void setStolenGoodie(Actor* goodie) { m_stolenGoodie = goodie; } // for restoring a snapshot; the goodie's own state isn't touched
+	virtual void saveState(SnapshotWriter& out) const;
+	virtual void restoreState(SnapshotReader& in);
 private:
 	int m_distanceBeforeTurning;
 	bool m_carryingGoodie;
@@ -146,6 +176,8 @@ public:
 
 	ThiefBotFactory(StudentWorld* world, int startX, int startY, ProductType type);
 	virtual void doSomething();
+	virtual void saveState(SnapshotWriter& out) const;
+	virtual void restoreState(SnapshotReader& in);
 private:
 	ProductType m_type;
 };
@@ -157,6 +189,8 @@ class Pea : public Actor
 		virtual bool allowsAgentColocation() const { return true; }
 		virtual void doSomething();
 		bool checkForActors();
+		virtual void saveState(SnapshotWriter& out) const;
+		virtual void restoreState(SnapshotReader& in);
 	private:
 		bool m_newPea;
 };
@@ -167,6 +201,7 @@ class Exit : public Actor
 		Exit(StudentWorld* world, int startX, int startY);
 		virtual bool allowsAgentColocation() const { return true; }
 		virtual bool isInvisibleAtFirst() const { return true; }
+		virtual bool isStatic() const { return true; }
 		virtual void doSomething();
 	private:
 };
@@ -175,6 +210,7 @@ class Wall : public Actor
 {
 	public:
 		Wall(StudentWorld* world, int startX, int startY);
+		virtual bool isStatic() const { return true; }
 		virtual void doSomething() {}
 	private:
 };
@@ -182,11 +218,14 @@ class Wall : public Actor
 class Marble : public Actor {
 public:
 	Marble(StudentWorld* world, int startX, int startY);
+	virtual bool isStatic() const { return true; }
 	virtual void doSomething() {}
 	virtual bool isDestroyable() const { return true; }
 	virtual bool isSwallowable() const { return true; }
 	virtual void damage(int damageAmt);
 	virtual bool bePushedBy(Agent* a, int x, int y);
+	virtual void saveState(SnapshotWriter& out) const;
+	virtual void restoreState(SnapshotReader& in);
 private:
 	int m_hitpoints;
 };
@@ -196,6 +235,7 @@ class Pit : public Actor
 public:
 	Pit(StudentWorld* world, int startX, int startY);
 	virtual bool allowsMarble() const { return true; }
+	virtual bool isStatic() const { return true; }
 	virtual void doSomething();
 };
 
@@ -203,6 +243,7 @@ class Item : public Actor {
 public:
 	Item(StudentWorld* world, int startX, int startY, int imageID, int score);
 	virtual bool allowsAgentColocation() const { return true; }
+	virtual bool isStatic() const { return true; }
 	int getScoreValue() const;
 private:
 	int m_scoreValue;
@@ -226,6 +267,8 @@ public:
 
 	// Set whether this goodie is currently stolen.
 	virtual void setStolen(bool status);
+	virtual void saveState(SnapshotWriter& out) const;
+	virtual void restoreState(SnapshotReader& in);
 private:
 	bool m_stolen;
 };
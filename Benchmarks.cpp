@@ -0,0 +1,416 @@
+#include "Benchmarks.h"
+#include "StudentWorld.h"
+#include "Actor.h"
+#include "HeadlessDriver.h"
+#include "ObjectPool.h"
+#include "GameConstants.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <chrono>
+#include <cstdint>
+using namespace std;
+
+using Clock = chrono::steady_clock;
+
+static double microsSince(Clock::time_point start)
+{
+	return chrono::duration<double, micro>(Clock::now() - start).count();
+}
+
+  // Every empty square off the player's row, to spread peas over so no one square's
+  // occupant list gets long
+static vector<int> emptySquares(const StudentWorld& world)
+{
+	vector<int> squares;
+	for (int y = 0; y < VIEW_HEIGHT; y++)
+		for (int x = 0; x < VIEW_WIDTH; x++)
+			if (y != world.getPlayer()->getY() && world.getCellFlags(x, y) == 0)
+				squares.push_back(y * VIEW_WIDTH + x);
+	return squares;
+}
+
+  // Live peas, oldest first
+static vector<Actor*> livePeas()
+{
+	vector<Actor*> peas;
+	const GraphObjectRegistry& registry = GraphObject::getGraphObjects();
+	for (int depth = 0; depth < GraphObjectRegistry::NUM_DEPTHS; depth++)
+		for (GraphObjectRegistry::const_iterator p = registry.begin(depth); p != registry.end(depth); p++)
+		{
+			Actor* actor = dynamic_cast<Actor*>(*p);
+			if (actor != nullptr && actor->getType() == IID_PEA && actor->isAlive())
+				peas.push_back(actor);
+		}
+	sort(peas.begin(), peas.end(),
+		[](const Actor* a, const Actor* b) { return a->getSpawnOrder() < b->getSpawnOrder(); });
+	return peas;
+}
+
+struct RemovalRun
+{
+	double	microsPerTick;  // in removeDeadGameObjects alone
+	size_t	actors;  // in the world, peas included
+	string	finalState;  // a snapshot, to check the paths being compared agree
+};
+
+  // Keep population peas alive on level 0, and each tick fire peasPerTick more and kill
+  // the peasPerTick oldest, as if they'd hit something.  The dead are then followed in
+  // the actor list by all the younger peas, as they are in a real shoot-out.
+static bool removeManyPeas(string assetPath, int referencePaths, int population, int peasPerTick, int ticks, RemovalRun& run)
+{
+	StudentWorld world(assetPath);
+	world.setRandomSeed(1);
+	world.useReferencePaths(referencePaths);
+	if (world.init() != GWSTATUS_CONTINUE_GAME)
+		return false;
+	vector<int> squares = emptySquares(world);
+	if (squares.empty())
+		return false;
+
+	size_t nextSquare = 0;
+	double micros = 0;
+	for (int t = -1; t < ticks; t++)  // the first round just fires the population
+	{
+		int toFire = (t < 0 ? population : peasPerTick);
+		for (int k = 0; k < toFire; k++, nextSquare = (nextSquare + 1) % squares.size())
+			world.createNewPea(squares[nextSquare] % VIEW_WIDTH, squares[nextSquare] / VIEW_WIDTH, GraphObject::right);
+		if (t < 0)
+			continue;
+
+		vector<Actor*> peas = livePeas();
+		for (int k = 0; k < peasPerTick; k++)
+			peas[k]->kill();
+		Clock::time_point start = Clock::now();
+		world.removeDeadGameObjects();
+		micros += microsSince(start);
+	}
+	run.microsPerTick = micros / ticks;
+	run.actors = GraphObject::getGraphObjects().size();
+	return world.saveSnapshot(run.finalState);
+}
+
+int runRemovalBench(string assetPath)
+{
+	const int POPULATIONS[] = { 500, 2000 };
+	const int PEAS_PER_TICK = 100;
+	const int TICKS = 1000;
+
+	for (int population : POPULATIONS)
+	{
+		RemovalRun before, after;
+		if (!removeManyPeas(assetPath, StudentWorld::ERASE_DEAD_ONE_AT_A_TIME, population, PEAS_PER_TICK, TICKS, before)  ||
+			!removeManyPeas(assetPath, 0, population, PEAS_PER_TICK, TICKS, after))
+		{
+			cout << "Level 0 couldn't be loaded, or has no room for peas" << endl;
+			return 1;
+		}
+
+		cout << "Removing the oldest " << PEAS_PER_TICK << " of " << population << " peas each tick ("
+			 << after.actors << " actors in all):" << endl;
+		cout << "  erasing one at a time: " << before.microsPerTick << "us/tick ("
+			 << before.microsPerTick * 1000 / PEAS_PER_TICK << "ns per dead actor)" << endl;
+		cout << "  one compaction: " << after.microsPerTick << "us/tick ("
+			 << after.microsPerTick * 1000 / PEAS_PER_TICK << "ns per dead actor)" << endl;
+		if (before.finalState != after.finalState)
+		{
+			cerr << "***** The two ways of removing dead actors left different worlds" << endl;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+  // Keep live peas in flight, and each round destroy the oldest and create a new one in
+  // its place, as shots hit things and others are fired.  Returns ns per create+destroy.
+template<typename Create, typename Destroy>
+static double churnPeas(StudentWorld& world, int live, int rounds, Create create, Destroy destroy)
+{
+	vector<Pea*> peas;
+	for (int k = 0; k < live; k++)
+		peas.push_back(create(&world, k % VIEW_WIDTH, 0));
+	Clock::time_point start = Clock::now();
+	for (int r = 0; r < rounds; r++)
+	{
+		int oldest = r % live;
+		destroy(peas[oldest]);
+		peas[oldest] = create(&world, r % VIEW_WIDTH, 0);
+	}
+	double micros = microsSince(start);
+	for (Pea* pea : peas)
+		destroy(pea);
+	return micros * 1000 / rounds;
+}
+
+int runPoolBench(string assetPath)
+{
+	const int LIVE[] = { 16, 256, 4096 };
+	const int ROUNDS = 2000000;
+
+	StudentWorld world(assetPath);
+	if (world.init() != GWSTATUS_CONTINUE_GAME)
+	{
+		cout << "Level 0 couldn't be loaded" << endl;
+		return 1;
+	}
+	for (int live : LIVE)
+	{
+		double heapNanos = churnPeas(world, live, ROUNDS,
+			[](StudentWorld* w, int x, int y) { return new Pea(w, x, y, GraphObject::right); },
+			[](Pea* pea) { delete pea; });
+		ObjectPool<Pea> pool;
+		double poolNanos = churnPeas(world, live, ROUNDS,
+			[&pool](StudentWorld* w, int x, int y) { return pool.create(w, x, y, GraphObject::right); },
+			[&pool](Pea* pea) { pool.destroy(pea); });
+
+		cout << "Replacing the oldest of " << live << " live peas, " << ROUNDS << " times:" << endl;
+		cout << "  new and delete: " << heapNanos << "ns per create+destroy" << endl;
+		cout << "  object pool: " << poolNanos << "ns per create+destroy" << endl;
+	}
+	return 0;
+}
+
+struct LoadRun
+{
+	double	loadMicros;  // per init()
+	double	teardownMicros;  // per cleanUp()
+	size_t	actors;
+	string	finalState;
+};
+
+  // Load level and tear it down reps times; false if there's no such level
+static bool reloadLevel(string assetPath, int referencePaths, int level, int reps, LoadRun& run)
+{
+	StudentWorld world(assetPath);
+	world.setRandomSeed(1);
+	world.useReferencePaths(referencePaths);
+	for (int k = 0; k < level; k++)
+		world.advanceToNextLevel();
+	if (world.init() != GWSTATUS_CONTINUE_GAME)
+		return false;
+	run.actors = GraphObject::getGraphObjects().size();
+
+	double loadMicros = 0;
+	double teardownMicros = 0;
+	for (int r = 0; r < reps; r++)
+	{
+		Clock::time_point start = Clock::now();
+		world.cleanUp();
+		teardownMicros += microsSince(start);
+		start = Clock::now();
+		world.init();
+		loadMicros += microsSince(start);
+	}
+	run.loadMicros = loadMicros / reps;
+	run.teardownMicros = teardownMicros / reps;
+	return world.saveSnapshot(run.finalState);
+}
+
+int runLoadBench(string assetPath)
+{
+	const int REPS = 2000;
+
+	int level = 0;
+	for (LoadRun before, after; reloadLevel(assetPath, StudentWorld::HEAP_ACTORS, level, REPS, before); level++)
+	{
+		reloadLevel(assetPath, 0, level, REPS, after);
+		cout << "Level " << level << " (" << after.actors << " objects):" << endl;
+		cout << "  new and delete: load " << before.loadMicros << "us, teardown " << before.teardownMicros << "us" << endl;
+		cout << "  level arena: load " << after.loadMicros << "us, teardown " << after.teardownMicros << "us" << endl;
+		if (before.finalState != after.finalState)
+		{
+			cerr << "***** The two ways of allocating actors loaded different worlds" << endl;
+			return 1;
+		}
+	}
+	if (level == 0)
+	{
+		cout << "Level 0 couldn't be loaded" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+  // What displayGamePlay reads from an object it queues, summed so the reads aren't optimized away
+static double readSprite(GraphObject* go)
+{
+	go->animate();
+	double x, y;
+	go->getAnimationLocation(x, y);
+	return x + y + go->getDirection() + go->getAnimationNumber() + go->getSize();
+}
+
+struct DrawOrderRun
+{
+	double	scanMicros;  // per frame
+	double	bucketMicros;
+	size_t	objects;
+};
+
+  // Time finding every depth's visible objects, back to front, for frames frames
+static bool timeDrawOrder(int frames, DrawOrderRun& run)
+{
+	vector<GraphObject*> objects;  // in the order the single dense array held them
+	map<int, int> imageDepths;  // as GameController's m_imageDepthMap was
+	GraphObjectRegistry buckets;  // without a GameController the real registry's objects are all at depth 0
+	const GraphObjectRegistry& registry = GraphObject::getGraphObjects();
+	for (int depth = 0; depth < GraphObjectRegistry::NUM_DEPTHS; depth++)
+		for (GraphObjectRegistry::const_iterator p = registry.begin(depth); p != registry.end(depth); p++)
+		{
+			int imageID = static_cast<Actor*>(*p)->getType();  // a headless world holds only actors
+			objects.push_back(*p);
+			imageDepths[imageID] = IMAGE_DEPTHS[imageID];
+			buckets.add(*p, IMAGE_DEPTHS[imageID]);
+		}
+	run.objects = objects.size();
+
+	double scanSum = 0;
+	Clock::time_point start = Clock::now();
+	for (int f = 0; f < frames; f++)
+		for (int i = GraphObjectRegistry::NUM_DEPTHS - 1; i >= 0; --i)
+			for (GraphObject* go : objects)
+				if (imageDepths.at(static_cast<Actor*>(go)->getType()) == i && go->isVisible())
+					scanSum += readSprite(go);
+	run.scanMicros = microsSince(start) / frames;
+
+	double bucketSum = 0;
+	start = Clock::now();
+	for (int f = 0; f < frames; f++)
+		for (int i = GraphObjectRegistry::NUM_DEPTHS - 1; i >= 0; --i)
+			for (GraphObjectRegistry::const_iterator p = buckets.begin(i); p != buckets.end(i); p++)
+				if ((*p)->isVisible())
+					bucketSum += readSprite(*p);
+	run.bucketMicros = microsSince(start) / frames;
+	return scanSum == bucketSum;
+}
+
+int runDrawOrderBench(string assetPath)
+{
+	const int FRAMES = 20000;
+	const int PEAS = 2000;
+
+	  // each level as loaded, then level 0 in a shoot-out
+	for (int level = 0; ; level++)
+	{
+		StudentWorld world(assetPath);
+		for (int k = 0; k < level; k++)
+			world.advanceToNextLevel();
+		if (world.init() != GWSTATUS_CONTINUE_GAME)
+		{
+			if (level > 0)
+				break;
+			cout << "Level 0 couldn't be loaded" << endl;
+			return 1;
+		}
+		DrawOrderRun run;
+		bool sameSprites = timeDrawOrder(FRAMES, run);
+		cout << "Level " << level << " (" << run.objects << " objects): scanning every depth "
+			 << run.scanMicros << "us/frame, depth buckets " << run.bucketMicros << "us/frame" << endl;
+		if (!sameSprites)
+		{
+			cerr << "***** The two ways of finding objects to draw found different ones" << endl;
+			return 1;
+		}
+	}
+
+	StudentWorld world(assetPath);
+	world.init();
+	vector<int> squares = emptySquares(world);
+	for (int k = 0; k < PEAS && !squares.empty(); k++)
+		world.createNewPea(squares[k % squares.size()] % VIEW_WIDTH, squares[k % squares.size()] / VIEW_WIDTH, GraphObject::right);
+	DrawOrderRun run;
+	bool sameSprites = timeDrawOrder(FRAMES / 10, run);
+	cout << "Level 0 with " << PEAS << " peas (" << run.objects << " objects): scanning every depth "
+		 << run.scanMicros << "us/frame, depth buckets " << run.bucketMicros << "us/frame" << endl;
+	if (!sameSprites)
+	{
+		cerr << "***** The two ways of finding objects to draw found different ones" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+struct Trajectory
+{
+	long long	ticks;
+	int			score;
+	double		moveMicros;
+	vector<uint64_t> stateHashes;  // of the world's snapshot after each tick
+	string		finalState;
+};
+
+static uint64_t hashState(const string& state)
+{
+	uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+	for (char c : state)
+		hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+	return hash;
+}
+
+  // Play one game, as HeadlessDriver does, for at most maxTicks ticks
+static void playTrajectory(string assetPath, int referencePaths, unsigned long long seed, unsigned int keySeed,
+						   long long maxTicks, Trajectory& run)
+{
+	StudentWorld world(assetPath);
+	world.setRandomSeed(seed);
+	world.useReferencePaths(referencePaths);
+	RandomKeySource keys(keySeed);
+	world.setKeySource(&keys);
+
+	run.ticks = 0;
+	run.moveMicros = 0;
+	string state;
+	int status = world.init();
+	while (status == GWSTATUS_CONTINUE_GAME && run.ticks < maxTicks)
+	{
+		Clock::time_point start = Clock::now();
+		status = world.move();
+		run.moveMicros += microsSince(start);
+		run.ticks++;
+		world.saveSnapshot(state);
+		run.stateHashes.push_back(hashState(state));
+
+		if (status == GWSTATUS_PLAYER_DIED)
+		{
+			world.cleanUp();
+			if (!world.isGameOver())
+				status = world.init();
+		}
+		else if (status == GWSTATUS_FINISHED_LEVEL)
+		{
+			world.advanceToNextLevel();
+			world.cleanUp();
+			status = world.init();
+		}
+	}
+	run.score = world.getScore();
+	world.saveSnapshot(run.finalState);
+}
+
+int runDispatchCheck(string assetPath, unsigned long long seed, unsigned int keySeed, long long ticks)
+{
+	Trajectory tagged, virtualCalls;
+	playTrajectory(assetPath, 0, seed, keySeed, ticks, tagged);
+	playTrajectory(assetPath, StudentWorld::VIRTUAL_TICKS, seed, keySeed, ticks, virtualCalls);
+
+	cout << "Seed " << seed << ", key seed " << keySeed << ": " << tagged.ticks << " ticks, score " << tagged.score << endl;
+	cout << "  type-tag dispatch: " << tagged.moveMicros / tagged.ticks << "us/tick" << endl;
+	cout << "  virtual calls: " << virtualCalls.moveMicros / virtualCalls.ticks << "us/tick" << endl;
+
+	size_t firstDifference = 0;
+	while (firstDifference < tagged.stateHashes.size() && firstDifference < virtualCalls.stateHashes.size()  &&
+		   tagged.stateHashes[firstDifference] == virtualCalls.stateHashes[firstDifference])
+		firstDifference++;
+	if (tagged.ticks != virtualCalls.ticks || tagged.score != virtualCalls.score  ||
+		firstDifference != tagged.stateHashes.size() || tagged.finalState != virtualCalls.finalState)
+	{
+		cerr << "***** The two ways of ticking actors diverged after tick " << firstDifference + 1
+			 << " (scores " << tagged.score << " and " << virtualCalls.score << ", "
+			 << tagged.ticks << " and " << virtualCalls.ticks << " ticks)" << endl;
+		return 1;
+	}
+	cout << "  the world was identical after every tick" << endl;
+	return 0;
+}
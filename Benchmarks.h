@@ -0,0 +1,29 @@
+#ifndef BENCHMARKS_H_
+#define BENCHMARKS_H_
+
+#include <string>
+
+// Timing runs and checks chosen from main's command line.  Each one plays its part of
+// the game without a window, prints what it measured, and returns main's exit status:
+// nonzero if the world couldn't be set up or the paths being compared didn't agree.
+
+  // Time a tick that removes many dead peas, erasing them one at a time and with the
+  // single compaction removeDeadGameObjects does
+int runRemovalBench(std::string assetPath);
+
+  // Time constructing and destroying peas in an ObjectPool against new and delete
+int runPoolBench(std::string assetPath);
+
+  // Time loading each level and tearing it down, with its actors allocated one by one
+  // on the heap and in the level arena
+int runLoadBench(std::string assetPath);
+
+  // Time finding each depth's objects to draw, by scanning every object and looking up its
+  // image's depth as displayGamePlay once did and by walking the registry's depth buckets
+int runDrawOrderBench(std::string assetPath);
+
+  // Play the same seeded game with actors ticked by type-tag dispatch and by virtual
+  // doSomething calls, checking the world is identical after every tick
+int runDispatchCheck(std::string assetPath, unsigned long long seed, unsigned int keySeed, long long ticks);
+
+#endif // BENCHMARKS_H_
@@ -1,9 +1,6 @@
 #ifndef GAMECONSTANTS_H_
 #define GAMECONSTANTS_H_
 
-#include <random>
-#include <utility>
-
 // image IDs for the game objects
 
 const int IID_PLAYER = 0;
@@ -21,6 +18,27 @@ const int IID_RESTORE_HEALTH = 11;
 const int IID_EXTRA_LIFE = 12;
 const int IID_AMMO = 13;
 
+const int NUM_IMAGE_IDS = 14;  // image IDs run from 0 to NUM_IMAGE_IDS-1
+
+// display depth of each image, indexed by image ID; depth 0 is drawn on top
+
+const int IMAGE_DEPTHS[NUM_IMAGE_IDS] = {
+	0,  // IID_PLAYER
+	0,  // IID_RAGEBOT
+	0,  // IID_THIEFBOT
+	0,  // IID_MEAN_THIEFBOT
+	2,  // IID_ROBOT_FACTORY
+	1,  // IID_PEA
+	2,  // IID_WALL
+	2,  // IID_EXIT
+	2,  // IID_MARBLE
+	2,  // IID_PIT
+	2,  // IID_CRYSTAL
+	2,  // IID_RESTORE_HEALTH
+	2,  // IID_EXTRA_LIFE
+	2   // IID_AMMO
+};
+
 // sounds
 
 const int SOUND_THEME			= 0;
@@ -36,6 +54,8 @@ const int SOUND_ROBOT_IMPACT	= 9;
 const int SOUND_PLAYER_IMPACT	= 10;
 const int SOUND_ROBOT_MUNCH		= 11;
 
+const int NUM_SOUNDS			= 12;  // sound IDs run from 0 to NUM_SOUNDS-1
+
 const int SOUND_NONE			= -1;
 
 // keys the user can hit
@@ -68,17 +88,4 @@ const int GWSTATUS_NOT_IMPLEMENTED	= 5;
 const double SPRITE_WIDTH_GL = .6; // note - this is tied implicitly to SPRITE_WIDTH due to carey's sloppy openGL programming
 const double SPRITE_HEIGHT_GL = .5; // note - this is tied implicitly to SPRITE_HEIGHT due to carey's sloppy openGL programming
 
-// Return a uniformly distributed random int from min to max, inclusive
-
-inline
-int randInt(int min, int max)
-{
-	if (max < min)
-		std::swap(max, min);
-	static std::random_device rd;
-	static std::default_random_engine generator(rd());
-	std::uniform_int_distribution<> distro(min, max);
-	return distro(generator);
-}
-
 #endif // GAMECONSTANTS_H_
@@ -11,7 +11,8 @@
 #include "SpriteManager.h"
 #include <iostream>
 #include <string>
-#include <map>
+#include <cassert>
+#include <set>
 #include <utility>
 #include <cstdlib>
 #include <algorithm>
@@ -61,12 +62,9 @@ struct SpriteInfo
 	unsigned int frameNum;
 	std::string	 tgaFileName;
 	std::string	 imageName;
-	int			 depth;
 };
 
 static void convertToGlutCoords(double x, double y, double& gx, double& gy, double& gz);
-static void drawPrompt(string mainMessage, string secondMessage);
-static void drawScoreAndLives(string);
 
 enum GameController::GameControllerState : int {
     welcome, init, makemove, animate, contgame, finishedlevel, gameover, cleanup, quit, prompt, not_applicable
@@ -77,32 +75,38 @@ int GameController::m_msPerTick;
 void GameController::initDrawersAndSounds()
 {
 	SpriteInfo drawers[] = {
-		{ IID_PLAYER      , 0, "dude_1.tga", "PLAYER", 0 },
-		{ IID_PLAYER      , 1, "dude_2.tga", "PLAYER", 0 },
-		{ IID_PLAYER      , 2, "dude_3.tga", "PLAYER", 0 },
-		{ IID_THIEFBOT    , 0, "thiefbot-1.tga", "THIEFBOT", 0 },
-		{ IID_THIEFBOT    , 1, "thiefbot-2.tga", "THIEFBOT", 0 },
-		{ IID_THIEFBOT    , 2, "thiefbot-3.tga", "THIEFBOT", 0 },
-		{ IID_MEAN_THIEFBOT  , 0, "thiefbot-1.tga", "MEAN_THIEFBOT", 0 },
-		{ IID_MEAN_THIEFBOT  , 1, "thiefbot-2.tga", "MEAN_THIEFBOT", 0 },
-		{ IID_MEAN_THIEFBOT  , 2, "thiefbot-3.tga", "MEAN_THIEFBOT", 0 },
-		{ IID_RAGEBOT     , 0, "ragebot-1.tga", "RAGEBOT", 0  },
-		{ IID_RAGEBOT     , 1, "ragebot-2.tga", "RAGEBOT", 0 },
-		{ IID_RAGEBOT     , 2, "ragebot-3.tga", "RAGEBOT", 0 },
-		{ IID_RAGEBOT     , 3, "ragebot-4.tga", "RAGEBOT", 0 },
-		{ IID_PEA         , 0, "pea.tga", "PEA", 1 },
-		{ IID_ROBOT_FACTORY   , 0, "factory.tga", "ROBOT_FACTORY", 2 },
-		{ IID_CRYSTAL     , 0, "crystal.tga", "CRYSTAL", 2 },
-		{ IID_RESTORE_HEALTH  , 0, "medkit.tga", "RESTORE_HEALTH", 2 },
-		{ IID_EXTRA_LIFE  , 0, "extralife.tga", "EXTRA_LIFE", 2 },
-		{ IID_AMMO        , 0, "ammo.tga", "AMMO", 2 },
-		{ IID_EXIT        , 0, "exit.tga", "EXIT", 2 },
-		{ IID_WALL        , 0, "wall.tga", "WALL", 2 },
-		{ IID_MARBLE      , 0, "marble.tga", "MARBLE", 2 },
-		{ IID_PIT         , 0, "pit.tga", "PIT", 2 }
+		{ IID_PLAYER      , 0, "dude_1.tga", "PLAYER" },
+		{ IID_PLAYER      , 1, "dude_2.tga", "PLAYER" },
+		{ IID_PLAYER      , 2, "dude_3.tga", "PLAYER" },
+		{ IID_THIEFBOT    , 0, "thiefbot-1.tga", "THIEFBOT" },
+		{ IID_THIEFBOT    , 1, "thiefbot-2.tga", "THIEFBOT" },
+		{ IID_THIEFBOT    , 2, "thiefbot-3.tga", "THIEFBOT" },
+		{ IID_MEAN_THIEFBOT  , 0, "thiefbot-1.tga", "MEAN_THIEFBOT" },
+		{ IID_MEAN_THIEFBOT  , 1, "thiefbot-2.tga", "MEAN_THIEFBOT" },
+		{ IID_MEAN_THIEFBOT  , 2, "thiefbot-3.tga", "MEAN_THIEFBOT" },
+		{ IID_RAGEBOT     , 0, "ragebot-1.tga", "RAGEBOT" },
+		{ IID_RAGEBOT     , 1, "ragebot-2.tga", "RAGEBOT" },
+		{ IID_RAGEBOT     , 2, "ragebot-3.tga", "RAGEBOT" },
+		{ IID_RAGEBOT     , 3, "ragebot-4.tga", "RAGEBOT" },
+		{ IID_PEA         , 0, "pea.tga", "PEA" },
+		{ IID_ROBOT_FACTORY   , 0, "factory.tga", "ROBOT_FACTORY" },
+		{ IID_CRYSTAL     , 0, "crystal.tga", "CRYSTAL" },
+		{ IID_RESTORE_HEALTH  , 0, "medkit.tga", "RESTORE_HEALTH" },
+		{ IID_EXTRA_LIFE  , 0, "extralife.tga", "EXTRA_LIFE" },
+		{ IID_AMMO        , 0, "ammo.tga", "AMMO" },
+		{ IID_EXIT        , 0, "exit.tga", "EXIT" },
+		{ IID_WALL        , 0, "wall.tga", "WALL" },
+		{ IID_MARBLE      , 0, "marble.tga", "MARBLE" },
+		{ IID_PIT         , 0, "pit.tga", "PIT" }
 	};
 
-	m_soundMap = {
+	struct SoundInfo
+	{
+		int soundID;
+		const char* soundFileName;
+	};
+
+	SoundInfo sounds[] = {
 		{ SOUND_THEME         , "theme.wav" },
 		{ SOUND_PLAYER_FIRE   , "torpedo.wav" },
 		{ SOUND_ENEMY_FIRE    , "pop.wav" },
@@ -117,6 +121,12 @@ void GameController::initDrawersAndSounds()
 		{ SOUND_ROBOT_BORN    , "materialize.wav" },
 	};
 
+	for (const auto& s : sounds)
+	{
+		assert(s.soundID >= 0 && s.soundID < NUM_SOUNDS);
+		m_soundMap[s.soundID] = s.soundFileName;
+	}
+
 	for (const auto& d : drawers)
 	{
 		string path = m_gw->assetPath();
@@ -126,8 +136,21 @@ void GameController::initDrawersAndSounds()
 			cerr << "Error loading sprite: " << (path+d.tgaFileName) << endl;
 			setGameState(quit);
 		}
+		assert(d.imageID < static_cast<unsigned int>(NUM_IMAGE_IDS));
 		m_imageNameMap[d.imageID] = d.imageName;
-		m_imageDepthMap[d.imageID] = d.depth;
+	}
+
+	for (int imageID = 0; imageID < NUM_IMAGE_IDS; imageID++)
+		GraphObject::setImageDepth(imageID, IMAGE_DEPTHS[imageID]);
+
+	  // objects that stay put are drawn from a cached layer rather than every frame
+	const int staticImages[] = { IID_WALL, IID_ROBOT_FACTORY, IID_PIT };
+	for (int imageID : staticImages)
+		GraphObject::setImageStatic(imageID, true);
+
+	if (!m_spriteManager.buildAtlases()) {
+		cerr << "Error packing sprites into texture atlases" << endl;
+		setGameState(quit);
 	}
 }
 
@@ -140,9 +163,9 @@ bool GameController::passesThruWhenSingleStepping(int key) const
 	return passThruKeys.find(key) != passThruKeys.end();
 }
 
-static void doSomethingCallback()
+static void displayCallback()
 {
-	Game().doSomething();
+	Game().redisplay();  // GLUT calls this only when the window needs repainting
 }
 
 static void reshapeCallback(int w, int h)
@@ -162,9 +185,53 @@ static void specialKeyboardEventCallback(int key, int x, int y)
 
 void GameController::timerFuncCallback(int)
 {
-	Game().doSomething();
-	this_thread::sleep_for(chrono::milliseconds(m_msPerTick));
-    glutTimerFunc(0, timerFuncCallback, 0);
+	Game().runScheduledTick();
+}
+
+  // Ticks are due at fixed deadlines m_msPerTick apart, so the time a tick takes doesn't
+  // delay the ones after it.  A GLUT timer can only wait whole milliseconds, so it's set
+  // to fire a little early and the rest of the wait is done here.  After falling more
+  // than MAX_TICKS_BEHIND ticks behind (e.g., the machine was busy or the window was being
+  // dragged), we give up catching up and schedule from now.
+void GameController::runScheduledTick()
+{
+	using Clock = chrono::steady_clock;
+	using Micros = chrono::duration<double, micro>;
+	const int MAX_TICKS_BEHIND = 5;
+	const Clock::duration period = chrono::milliseconds(m_msPerTick);
+
+	if (m_fastForward)
+	{
+		doSomething();
+		glutTimerFunc(0, timerFuncCallback, 0);
+		return;
+	}
+
+	Clock::time_point now = Clock::now();
+	if (m_nextTickDeadline - now > chrono::milliseconds(1))
+	{
+		auto wait = chrono::duration_cast<chrono::milliseconds>(m_nextTickDeadline - now) - chrono::milliseconds(1);
+		glutTimerFunc(static_cast<unsigned int>(wait.count()), timerFuncCallback, 0);
+		return;
+	}
+	this_thread::sleep_until(m_nextTickDeadline);
+
+	now = Clock::now();
+	m_tickStats.recordTick(Micros(now - m_nextTickDeadline).count(), Micros(now - m_lastTickStart).count());
+	m_lastTickStart = now;
+
+	doSomething();
+
+	m_nextTickDeadline += period;
+	now = Clock::now();
+	if (now - m_nextTickDeadline > MAX_TICKS_BEHIND * period)
+	{
+		m_nextTickDeadline = now + period;
+		m_tickStats.recordResync();
+	}
+
+	auto wait = chrono::duration_cast<chrono::milliseconds>(m_nextTickDeadline - now);
+	glutTimerFunc(wait.count() > 1 ? static_cast<unsigned int>(wait.count() - 1) : 0, timerFuncCallback, 0);
 }
 
 void windowCloseCallback()
@@ -183,7 +250,18 @@ void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTit
 	m_lastKeyHit = INVALID_KEY;
 	m_singleStep = false;
 	m_curIntraFrameTick = 0;
+	m_movesMade = 0;
+	m_playSeconds = 0;
+	m_framesDrawn = 0;
+	m_frameMicros = 0;
+	m_spritesDrawn = 0;
+	m_spriteDrawCalls = 0;
+	m_spriteStateChanges = 0;
+	m_redrawNeeded = true;
 	m_playerWon = false;
+	m_staticLayerLists = 0;
+	m_staticLayerBuilt = false;
+	m_staticLayerVersion = 0;
 
 	glutInit(&argc, argv);
 
@@ -193,18 +271,38 @@ void GameController::run(int argc, char* argv[], GameWorld* gw, string windowTit
 	glutCreateWindow(windowTitle.c_str());
 
 	initDrawersAndSounds();  // won't work unless *after* window created
+	m_textRenderer.buildGlyphAtlas();  // likewise needs the window's GL context
 
 	glutKeyboardFunc(keyboardEventCallback);
 	glutSpecialFunc(specialKeyboardEventCallback);
 	glutReshapeFunc(reshapeCallback);
-	glutDisplayFunc(doSomethingCallback);
+	glutDisplayFunc(displayCallback);
+	m_nextTickDeadline = m_lastTickStart = chrono::steady_clock::now();
 	glutTimerFunc(0, timerFuncCallback, 0);
 	glutWMCloseFunc(windowCloseCallback);
 
 	glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+	chrono::steady_clock::time_point runStart = chrono::steady_clock::now();
 	glutMainLoop();
+	chrono::steady_clock::time_point runEnd = chrono::steady_clock::now();
+	double wallSeconds = chrono::duration<double>(runEnd - runStart).count();
+	if (isPlaying(m_gameState))  // the window was closed mid-game
+		m_playSeconds += chrono::duration<double>(runEnd - m_playStart).count();
 	delete m_gw;
 	reportLeakedGraphObjects();
+	if (!m_fastForward)
+		m_tickStats.report(cerr, m_msPerTick * 1000.0);
+	  // how long someone took to press Enter says nothing about the game's speed
+	m_tickStats.reportThroughput(cerr, m_playSeconds);
+	cerr << "  plus " << wallSeconds - m_playSeconds << "s at prompts and loading levels" << endl;
+	if (m_framesDrawn > 0)
+	{
+		cerr << "Frames: " << m_framesDrawn << " drawn, " << m_frameMicros / m_framesDrawn
+			 << "us of CPU time each before the buffer swap" << endl;
+		cerr << "Moving sprites per frame: " << static_cast<double>(m_spritesDrawn) / m_framesDrawn << " in "
+			 << static_cast<double>(m_spriteDrawCalls) / m_framesDrawn << " draw calls, with "
+			 << static_cast<double>(m_spriteStateChanges) / m_framesDrawn << " GL state changes" << endl;
+	}
 }
 
 void GameController::keyboardEvent(unsigned char key, int /* x */, int /* y */)
@@ -241,20 +339,40 @@ void GameController::playSound(int soundID)
 	if (soundID == SOUND_NONE)
 		return;
 
-	auto p = m_soundMap.find(soundID);
-	if (p != m_soundMap.end())
+	assert(soundID >= 0 && soundID < NUM_SOUNDS);
+	const string& soundFile = m_soundMap[soundID];
+	if (!soundFile.empty())
 	{
 		string path = m_gw->assetPath();
 		if (!path.empty())
 			path += '/';
-		SoundFX().playClip(path + p->second);
+		SoundFX().playClip(path + soundFile);
 	}
 }
 
 void GameController::setGameState(GameControllerState s)
 {
     if (m_gameState != quit)
+	{
+		  // switching between a prompt and gameplay replaces the whole screen
+		if ((s == prompt) != (m_gameState == prompt))
+			m_redrawNeeded = true;
+		if (isPlaying(s) != isPlaying(m_gameState))
+		{
+			chrono::steady_clock::time_point now = chrono::steady_clock::now();
+			if (isPlaying(s))
+				m_playStart = now;
+			else
+				m_playSeconds += chrono::duration<double>(now - m_playStart).count();
+		}
         m_gameState = s;
+	}
+}
+
+  // True in the states that make moves and draw them, the ones the throughput report times
+bool GameController::isPlaying(GameControllerState s)
+{
+	return s == makemove || s == animate;
 }
 
 void GameController::quitGame()
@@ -270,8 +388,8 @@ void GameController::doSomething()
 			break;
 		case welcome:
 			playSound(SOUND_THEME);
-			m_mainMessage = "Welcome to Marble Madness!";
-			m_secondMessage = "Press Enter to begin play...";
+			m_mainMessage.set("Welcome to Marble Madness!");
+			m_secondMessage.set("Press Enter to begin play...");
 			setGameState(prompt);
 			m_nextStateAfterPrompt = init;
 			break;
@@ -290,14 +408,14 @@ void GameController::doSomething()
 					setGameState(gameover);
 					break;
 				  case GWSTATUS_LEVEL_ERROR:
-					m_mainMessage = "Error in level data file encoding!";
-					m_secondMessage = "Press Enter to quit...";
+					m_mainMessage.set("Error in level data file encoding!");
+					m_secondMessage.set("Press Enter to quit...");
 					setGameState(prompt);
 					m_nextStateAfterPrompt = quit;
 					break;
 				  default:
-					m_mainMessage = "StudentWorld::init returned a wrong status!";
-					m_secondMessage = "Press Enter to quit...";
+					m_mainMessage.set("StudentWorld::init returned a wrong status!");
+					m_secondMessage.set("Press Enter to quit...");
 					setGameState(prompt);
 					m_nextStateAfterPrompt = quit;
 					break;
@@ -308,7 +426,10 @@ void GameController::doSomething()
 			m_curIntraFrameTick = ANIMATION_POSITIONS_PER_TICK;
 			m_nextStateAfterAnimate = not_applicable;
 			{
+				chrono::steady_clock::time_point moveStart = chrono::steady_clock::now();
 				int status = m_gw->move();
+				m_tickStats.recordLatency(chrono::duration<double, micro>(chrono::steady_clock::now() - moveStart).count());
+				m_movesMade++;
 				switch (status)
 				{
 				  case GWSTATUS_PLAYER_DIED:
@@ -329,7 +450,10 @@ void GameController::doSomething()
 			setGameState(animate);
 			break;
 		case animate:
-			displayGamePlay();
+			  // If no object or HUD text changed, what's on screen is still right.
+			  // When fast forwarding, skipped ticks' changes show up in the next frame drawn.
+			if ((m_redrawNeeded || GraphObject::sceneChanged()) && m_movesMade % m_renderEvery == 0)
+				displayGamePlay();
 			if (m_curIntraFrameTick-- <= 0)
 			{
 				if (m_nextStateAfterAnimate != not_applicable)
@@ -349,14 +473,14 @@ void GameController::doSomething()
 			}
 			break;
 		case contgame:
-			m_mainMessage = "You lost a life!";
-			m_secondMessage = "Press Enter to continue playing...";
+			m_mainMessage.set("You lost a life!");
+			m_secondMessage.set("Press Enter to continue playing...");
 			setGameState(prompt);
 			m_nextStateAfterPrompt = cleanup;
 			break;
 		case finishedlevel:
-			m_mainMessage = "Woot! You finished the level!";
-			m_secondMessage = "Press Enter to continue playing...";
+			m_mainMessage.set("Woot! You finished the level!");
+			m_secondMessage.set("Press Enter to continue playing...");
 			setGameState(prompt);
 			m_nextStateAfterPrompt = cleanup;
 			break;
@@ -373,9 +497,9 @@ void GameController::doSomething()
 				ostringstream oss;
 				oss << (m_playerWon ? "You won the game!" : "Game Over!")
 					<< " Final score: " << m_gw->getScore() << "!";
-				m_mainMessage = oss.str();
+				m_mainMessage.set(oss.str());
 			}
-			m_secondMessage = "Press Enter to quit...";
+			m_secondMessage.set("Press Enter to quit...");
 			setGameState(prompt);
 			m_nextStateAfterPrompt = quit;
 			break;
@@ -389,7 +513,11 @@ void GameController::doSomething()
 			glutLeaveMainLoop();
 			break;
 		case prompt:
-			drawPrompt(m_mainMessage, m_secondMessage);
+			if (m_redrawNeeded)
+			{
+				drawPrompt();
+				m_redrawNeeded = false;
+			}
 			{
 				int key;
 				if (getKeyIfAny(key) && key == '\r')
@@ -400,8 +528,23 @@ void GameController::doSomething()
 }
 
 
+  // Repaint what's currently on screen without advancing the game
+void GameController::redisplay()
+{
+	forceRedraw();
+	if (m_gameState == prompt)
+	{
+		drawPrompt();
+		m_redrawNeeded = false;
+	}
+	else if (m_postInitPreCleanup)
+		displayGamePlay();
+}
+
 void GameController::displayGamePlay()
 {
+	chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+
 	glEnable(GL_DEPTH_TEST); // must be done each time before displaying graphics or gets disabled for some reason
 	glLoadIdentity();
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -414,14 +557,21 @@ void GameController::displayGamePlay()
 #pragma GCC diagnostic pop
 #endif
 
-  std::set<GraphObject*> &graphObjects = GraphObject::getGraphObjects();
+	GraphObjectRegistry& graphObjects = GraphObject::getGraphObjects();
+
+	if (!m_staticLayerBuilt || m_staticLayerVersion != GraphObject::staticLayerVersion())
+		rebuildStaticLayer();
 
+	m_spriteManager.beginFrame();
 	for (int i = GraphObject::NUM_DEPTHS - 1; i >= 0; --i)
 	{
-		for (auto it = graphObjects.begin(); it != graphObjects.end(); it++)
+		glCallList(m_staticLayerLists + i);
+		m_spriteManager.textureChanged();  // the list bound its own textures
+
+		for (auto it = graphObjects.begin(i); it != graphObjects.end(i); it++)
 		{
 			GraphObject* cur = *it;
-			if (m_imageDepthMap.at(cur->getID()) == i && cur->isVisible())
+			if (cur->isVisible() && !cur->isStaticImage())
 			{
 				cur->animate();
 
@@ -432,14 +582,62 @@ void GameController::displayGamePlay()
 				int angle = cur->getDirection();
 				int imageID = cur->getID();
 
-				m_spriteManager.plotSprite(imageID, cur->getAnimationNumber() % m_spriteManager.getNumFrames(imageID), gx, gy, gz, angle, cur->getSize());
+				m_spriteManager.queueSprite(imageID, cur->getAnimationNumber() % m_spriteManager.getNumFrames(imageID), gx, gy, gz, angle, cur->getSize());
 			}
 		}
+		m_spriteManager.flush();  // deeper layers must be drawn before the ones on top of them
 	}
+	const SpriteManager::FrameStats& stats = m_spriteManager.getFrameStats();
+	m_spritesDrawn += stats.sprites;
+	m_spriteDrawCalls += stats.drawCalls;
+	m_spriteStateChanges += stats.stateChanges;
 
-	drawScoreAndLives(m_gameStatText);
+	drawScoreAndLives();
 
+	  // the swap waits for the GPU (and maybe vsync), so it isn't counted
+	m_frameMicros += chrono::duration<double, micro>(chrono::steady_clock::now() - frameStart).count();
+	m_framesDrawn++;
 	glutSwapBuffers();
+
+	m_redrawNeeded = false;
+	GraphObject::sceneChanged() = false;
+}
+
+  // Compile the objects that stay put into one display list per depth.  Vertex arrays are
+  // copied into a list when it's compiled, so the lists can be replayed until a static
+  // object changes.
+void GameController::rebuildStaticLayer()
+{
+	if (m_staticLayerLists == 0)
+		m_staticLayerLists = glGenLists(GraphObject::NUM_DEPTHS);
+
+	GraphObjectRegistry& graphObjects = GraphObject::getGraphObjects();
+
+	for (int i = 0; i < GraphObject::NUM_DEPTHS; i++)
+	{
+		glNewList(m_staticLayerLists + i, GL_COMPILE);
+		m_spriteManager.textureChanged();  // the list must bind its textures itself
+		for (auto it = graphObjects.begin(i); it != graphObjects.end(i); it++)
+		{
+			GraphObject* cur = *it;
+			if (cur->isVisible() && cur->isStaticImage())
+			{
+				cur->animate();
+
+				double x, y, gx, gy, gz;
+				cur->getAnimationLocation(x, y);
+				convertToGlutCoords(x, y, gx, gy, gz);
+
+				int imageID = cur->getID();
+				m_spriteManager.queueSprite(imageID, cur->getAnimationNumber() % m_spriteManager.getNumFrames(imageID), gx, gy, gz, cur->getDirection(), cur->getSize());
+			}
+		}
+		m_spriteManager.flush();
+		glEndList();
+	}
+
+	m_staticLayerBuilt = true;
+	m_staticLayerVersion = GraphObject::staticLayerVersion();
 }
 
 void GameController::reportLeakedGraphObjects() const
@@ -451,9 +649,13 @@ void GameController::reportLeakedGraphObjects() const
 	else
 	{
 		cerr << "***** " << graphObjects.size() << " leaked objects" << endl;
-		for (GraphObject* go : graphObjects)
-			cerr << "At (" << go->getX() << "," << go->getY() << "): "
-						   <<  m_imageNameMap.at(go->m_imageID) << endl;
+		for (int i = 0; i < GraphObject::NUM_DEPTHS; i++)
+			for (auto it = graphObjects.begin(i); it != graphObjects.end(i); it++)
+			{
+				GraphObject* go = *it;
+				cerr << "At (" << go->getX() << "," << go->getY() << "): "
+							   <<  m_imageNameMap[go->m_imageID] << endl;
+			}
 		//totalLeaked += graphObjects.size();
 	}
 	//if (totalLeaked > 0)
@@ -462,6 +664,7 @@ void GameController::reportLeakedGraphObjects() const
 
 void GameController::reshape (int w, int h)
 {
+	m_redrawNeeded = true;
 	glViewport (0, 0, (GLsizei) w, (GLsizei) h);
 	glMatrixMode (GL_PROJECTION);
 	glLoadIdentity ();
@@ -485,53 +688,30 @@ static void convertToGlutCoords(double x, double y, double& gx, double& gy, doub
 	gz = .6 * VISIBLE_MIN_Z;
 }
 
-static void doOutputStroke(double x, double y, double z, double size, const char* str, bool centered)
-{
-	if (centered)
-	{
-		double len = glutStrokeLength(GLUT_STROKE_ROMAN, reinterpret_cast<const unsigned char*>(str)) / FONT_SCALEDOWN;
-		x = -len / 2;
-		size = 1;
-	}
-	GLfloat scaledSize = static_cast<GLfloat>(size / FONT_SCALEDOWN);
-	glPushMatrix();
-	glLineWidth(1);
-	glLoadIdentity();
-	glTranslatef(static_cast<GLfloat>(x), static_cast<GLfloat>(y), static_cast<GLfloat>(z));
-	glScalef(scaledSize, scaledSize, scaledSize);
-	for ( ; *str != '\0'; str++)
-		glutStrokeCharacter(GLUT_STROKE_ROMAN, *str);
-	glPopMatrix();
-}
-
-//static void outputStroke(double x, double y, double z, double size, const char* str)
-//{
-//	doOutputStroke(x, y, z, size, str, false);
-//}
-
-static void outputStrokeCentered(double y, double z, const char* str)
+void GameController::outputTextCentered(TextRenderer::Text& text, double y, double z)
 {
-	doOutputStroke(0, y, z, 1, str, true);
+	double len = m_textRenderer.width(text) / FONT_SCALEDOWN;
+	m_textRenderer.draw(text, -len / 2, y, z, 1 / FONT_SCALEDOWN);
 }
 
-static void drawPrompt(string mainMessage, string secondMessage)
+void GameController::drawPrompt()
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glColor3f (1.0, 1.0, 1.0);
 	glLoadIdentity ();
-	outputStrokeCentered(1, -5, mainMessage.c_str());
-	outputStrokeCentered(-1, -5, secondMessage.c_str());
+	outputTextCentered(m_mainMessage, 1, -5);
+	outputTextCentered(m_secondMessage, -1, -5);
 	glutSwapBuffers();
 }
 
-static void drawScoreAndLives(string gameStatText)
+void GameController::drawScoreAndLives()
 {
 	static int RATE = 1;
 	static GLfloat rgb[3] =
 		{ static_cast<GLfloat>(.6), static_cast<GLfloat>(.6), static_cast<GLfloat>(.6) };
 	for (int k = 0; k < 3; k++)
 	{
-		double strength = rgb[k] + randInt(-RATE, RATE) / 100.0;
+		double strength = rgb[k] + m_random.randInt(-RATE, RATE) / 100.0;
 		if (strength < .6)
 			strength = .6;
 		else if (strength > 1.0)
@@ -539,7 +719,7 @@ static void drawScoreAndLives(string gameStatText)
 		rgb[k] = static_cast<GLfloat>(strength);
 	}
 	glColor3f(rgb[0], rgb[1], rgb[2]);
-	outputStrokeCentered(SCORE_Y, SCORE_Z, gameStatText.c_str());
+	outputTextCentered(m_gameStatText, SCORE_Y, SCORE_Z);
 }
 
 #if defined(__APPLE__)
@@ -2,10 +2,14 @@
 #define GAMECONTROLLER_H_
 
 #include "SpriteManager.h"
+#include "TextRenderer.h"
+#include "GameConstants.h"
+#include "TickStats.h"
+#include "Random.h"
 #include <string>
-#include <map>
 #include <iostream>
 #include <sstream>
+#include <chrono>
 const int INVALID_KEY = 0;
 
 class GraphObject;
@@ -16,6 +20,20 @@ class GameController
   public:
 	void run(int argc, char* argv[], GameWorld* gw, std::string windowTitle, int msPerTick);
 
+	  // Call before run to tick as fast as possible instead of every msPerTick ms,
+	  // drawing the game only every renderEvery'th tick
+	void setFastForward(int renderEvery)
+	{
+		m_fastForward = true;
+		m_renderEvery = (renderEvery > 0 ? renderEvery : 1);
+	}
+
+	  // How many times run called the world's move
+	long long movesMade() const
+	{
+		return m_movesMade;
+	}
+
 	bool getKeyIfAny(int& value)
 	{
 		if (m_lastKeyHit != INVALID_KEY)
@@ -36,10 +54,22 @@ class GameController
 
 	void setGameStatText(std::string text)
 	{
-		m_gameStatText = text;
+		if (text != m_gameStatText.get())
+		{
+			m_gameStatText.set(text);  // its quads are rebuilt when it's next drawn
+			m_redrawNeeded = true;
+		}
+	}
+
+	  // The window's contents were lost (e.g., it was uncovered), so the next frame
+	  // must be drawn even if nothing in it changed.
+	void forceRedraw()
+	{
+		m_redrawNeeded = true;
 	}
 
 	void doSomething();
+	void redisplay();
 
 	void reshape(int w, int h);
 	void keyboardEvent(unsigned char key, int x, int y);
@@ -65,23 +95,46 @@ private:
 	int			m_lastKeyHit;
 	bool		m_singleStep;
 	bool		m_postInitPreCleanup;
-	std::string m_gameStatText;
-	std::string m_mainMessage;
-	std::string m_secondMessage;
+	TextRenderer::Text m_gameStatText;
+	TextRenderer::Text m_mainMessage;
+	TextRenderer::Text m_secondMessage;
 	int			m_curIntraFrameTick;
-	using SoundMapType = std::map<int, std::string>;
-	SoundMapType m_soundMap;
-	std::map<int, std::string> m_imageNameMap;
-	std::map<int, int> m_imageDepthMap;
+	bool		m_redrawNeeded;  // besides GraphObject changes, something on screen changed
+	std::string m_soundMap[NUM_SOUNDS];  // indexed by sound ID
+	std::string m_imageNameMap[NUM_IMAGE_IDS];  // indexed by image ID
 	bool		m_playerWon;
 	SpriteManager m_spriteManager;
+	TextRenderer m_textRenderer;
+	GLuint		m_staticLayerLists;  // one display list per depth, numbered consecutively
+	bool		m_staticLayerBuilt;
+	unsigned int m_staticLayerVersion;  // GraphObject static layer version the lists were built from
 	static int m_msPerTick;
+	std::chrono::steady_clock::time_point m_nextTickDeadline;
+	std::chrono::steady_clock::time_point m_lastTickStart;
+	std::chrono::steady_clock::time_point m_playStart;  // when the game last left a prompt
+	double		m_playSeconds;  // wall time spent making moves and animating, i.e., not at prompts
+	TickStats	m_tickStats;
+	Random		m_random;  // for display effects only, so they don't disturb the game's random numbers
+	bool		m_fastForward = false;
+	int			m_renderEvery = 1;
+	long long	m_movesMade;
+	long long	m_framesDrawn;
+	double		m_frameMicros;  // CPU time spent in displayGamePlay before swapping buffers
+	long long	m_spritesDrawn;  // totals of the SpriteManager's per-frame stats
+	long long	m_spriteDrawCalls;
+	long long	m_spriteStateChanges;
 
     void setGameState(GameControllerState s);
+	static bool isPlaying(GameControllerState s);
 
 	void initDrawersAndSounds();
 	bool passesThruWhenSingleStepping(int key) const;
 	void displayGamePlay();
+	void rebuildStaticLayer();
+	void drawPrompt();
+	void drawScoreAndLives();
+	void outputTextCentered(TextRenderer::Text& text, double y, double z);
+	void runScheduledTick();
 	void reportLeakedGraphObjects() const;
 
 };
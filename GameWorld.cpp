@@ -6,22 +6,38 @@ using namespace std;
 
 bool GameWorld::getKey(int& value)
 {
-	bool gotKey = m_controller->getKeyIfAny(value);
+	bool gotKey;
+	if (m_keySource != nullptr)
+		gotKey = m_keySource->getKey(value);
+	else if (m_controller != nullptr)
+		gotKey = m_controller->getKeyIfAny(value);
+	else
+		gotKey = false;
+
+	if (m_keyRecorder != nullptr)
+		m_keyRecorder->recordKey(gotKey, value);
 
 	if (gotKey)
 	{
 		if (value == 'q'  ||  value == '\x03')  // CTRL-C
-			m_controller->quitGame();
+		{
+			if (m_controller != nullptr)
+				m_controller->quitGame();
+			else
+				m_quitRequested = true;
+		}
 	}
 	return gotKey;
 }
 
 void GameWorld::playSound(int soundID)
 {
-	m_controller->playSound(soundID);
+	if (m_controller != nullptr)
+		m_controller->playSound(soundID);
 }
 
 void GameWorld::setGameStatText(string text)
 {
-	m_controller->setGameStatText(text);
+	if (m_controller != nullptr)
+		m_controller->setGameStatText(text);
 }
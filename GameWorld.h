@@ -2,19 +2,44 @@
 #define GAMEWORLD_H_
 
 #include "GameConstants.h"
+#include "Random.h"
 #include <string>
+#include <cstdint>
 
 const int START_PLAYER_LIVES = 3;
 
 class GameController;
 
+  // Where a GameWorld gets key presses from when it isn't run by a GameController
+class KeySource
+{
+public:
+	virtual ~KeySource()
+	{
+	}
+
+	virtual bool getKey(int& value) = 0;
+};
+
+  // Told the answer to every key request a GameWorld makes, e.g., to record a replay
+class KeyRecorder
+{
+public:
+	virtual ~KeyRecorder()
+	{
+	}
+
+	virtual void recordKey(bool gotKey, int value) = 0;
+};
+
 class GameWorld
 {
 public:
 
 	GameWorld(std::string assetPath)
 	 : m_lives(START_PLAYER_LIVES), m_score(0), m_level(0),
-	   m_controller(nullptr), m_assetPath(assetPath)
+	   m_controller(nullptr), m_keySource(nullptr), m_keyRecorder(nullptr), m_quitRequested(false),
+	   m_assetPath(assetPath)
 	{
 	}
 
@@ -61,6 +86,12 @@ public:
 		m_score += howMuch;
 	}
 
+	  // Return a uniformly distributed random int from min to max, inclusive
+	int randInt(int min, int max)
+	{
+		return m_random.randInt(min, max);
+	}
+
 	  // The following should be used by only the framework, not the student
 
 	bool isGameOver() const
@@ -78,6 +109,71 @@ public:
 		m_controller = controller;
 	}
 
+	  // Keys come from the key source if there is one, else from the controller.
+	  // Without a controller, sounds and status text are ignored.
+	void setKeySource(KeySource* keySource)
+	{
+		m_keySource = keySource;
+	}
+
+	void setKeyRecorder(KeyRecorder* keyRecorder)
+	{
+		m_keyRecorder = keyRecorder;
+	}
+
+	  // Make this world's random numbers, and so its play, repeatable
+	void setRandomSeed(std::uint64_t seed)
+	{
+		m_random.seed(seed);
+	}
+
+	  // For restoring a saved world
+	void setScore(int score)
+	{
+		m_score = score;
+	}
+
+	void setLives(int lives)
+	{
+		m_lives = lives;
+	}
+
+	void setLevel(int level)
+	{
+		m_level = level;
+	}
+
+	void getRandomState(std::uint64_t state[4]) const
+	{
+		m_random.getState(state);
+	}
+
+	void setRandomState(const std::uint64_t state[4])
+	{
+		m_random.setState(state);
+	}
+
+	  // Write the world's whole state into out, replacing its contents, so that
+	  // restoreSnapshot can later put the world back exactly as it was.  Call these
+	  // between ticks.  A world that doesn't support snapshots returns false.
+	virtual bool saveSnapshot(std::string& /* out */) const
+	{
+		return false;
+	}
+
+	  // Returns false if data isn't a snapshot this version can read, leaving the world
+	  // as it is after cleanUp
+	virtual bool restoreSnapshot(const std::string& /* data */)
+	{
+		return false;
+	}
+
+	  // The player asked to quit while there was no controller to tell
+	bool quitRequested() const
+	{
+		return m_quitRequested;
+	}
+
 	std::string assetPath() const
 	{
 		return m_assetPath;
@@ -88,7 +184,11 @@ private:
 	int				m_score;
 	int				m_level;
 	GameController* m_controller;
+	KeySource*		m_keySource;
+	KeyRecorder*	m_keyRecorder;
+	bool			m_quitRequested;
 	std::string		m_assetPath;
+	Random			m_random;
 };
 
 #endif // GAMEWORLD_H_
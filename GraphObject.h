@@ -1,14 +1,123 @@
 #ifndef GRAPHOBJ_H_
 #define GRAPHOBJ_H_
 
-#include "SpriteManager.h"
 #include "GameConstants.h"
 
-#include <set>
+#include <vector>
 #include <cmath>
+#include <cassert>
 
 const int ANIMATION_POSITIONS_PER_TICK = 1;
 
+class GraphObject;
+
+  // Registry of every live GraphObject: a slot map whose handles stay valid while the
+  // object lives, with O(1) add and remove.  Objects are packed densely in one bucket
+  // per display depth, so drawing a depth is a single linear pass.  No allocation per
+  // object once the vectors have grown.
+class GraphObjectRegistry
+{
+  public:
+	static const int NUM_DEPTHS = 4;
+
+	struct Handle
+	{
+		unsigned int slot;
+		unsigned int generation;
+	};
+
+	typedef std::vector<GraphObject*>::const_iterator const_iterator;
+
+	Handle add(GraphObject* go, int depth)
+	{
+		if (depth < 0 || depth >= NUM_DEPTHS)
+			depth = 0;
+
+		Handle h;
+		if (m_freeSlots.empty())
+		{
+			h.slot = static_cast<unsigned int>(m_slots.size());
+			m_slots.push_back(Slot());
+			m_slots.back().generation = 0;
+		}
+		else
+		{
+			h.slot = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		Slot& slot = m_slots[h.slot];
+		h.generation = slot.generation;
+		slot.depth = depth;
+		slot.denseIndex = static_cast<unsigned int>(m_dense[depth].size());
+		m_dense[depth].push_back(go);
+		m_denseToSlot[depth].push_back(h.slot);
+		return h;
+	}
+
+	void remove(Handle h)
+	{
+		if (get(h) == nullptr)
+			return;
+		  // move the last object of the bucket into the hole so the bucket stays packed
+		int depth = m_slots[h.slot].depth;
+		std::vector<GraphObject*>& dense = m_dense[depth];
+		std::vector<unsigned int>& denseToSlot = m_denseToSlot[depth];
+		unsigned int hole = m_slots[h.slot].denseIndex;
+		unsigned int last = static_cast<unsigned int>(dense.size()) - 1;
+		dense[hole] = dense[last];
+		denseToSlot[hole] = denseToSlot[last];
+		m_slots[denseToSlot[hole]].denseIndex = hole;
+		dense.pop_back();
+		denseToSlot.pop_back();
+		m_slots[h.slot].generation++;  // any outstanding copies of h are now stale
+		m_freeSlots.push_back(h.slot);
+	}
+
+	GraphObject* get(Handle h) const
+	{
+		if (h.slot >= m_slots.size() || m_slots[h.slot].generation != h.generation)
+			return nullptr;
+		const Slot& slot = m_slots[h.slot];
+		return m_dense[slot.depth][slot.denseIndex];
+	}
+
+	std::size_t size() const
+	{
+		std::size_t total = 0;
+		for (int depth = 0; depth < NUM_DEPTHS; depth++)
+			total += m_dense[depth].size();
+		return total;
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	const_iterator begin(int depth) const
+	{
+		return m_dense[depth].begin();
+	}
+
+	const_iterator end(int depth) const
+	{
+		return m_dense[depth].end();
+	}
+
+  private:
+	struct Slot
+	{
+		int				depth;
+		unsigned int	denseIndex;
+		unsigned int	generation;
+	};
+
+	std::vector<Slot>			m_slots;
+	std::vector<unsigned int>	m_freeSlots;
+	std::vector<GraphObject*>	m_dense[NUM_DEPTHS];
+	std::vector<unsigned int>	m_denseToSlot[NUM_DEPTHS];
+};
+
 class GraphObject
 {
   public:
@@ -27,17 +136,21 @@ class GraphObject
 		if (m_size <= 0)
 			m_size = 1;
 
-		getGraphObjects().insert(this);
+		m_registryHandle = getGraphObjects().add(this, getImageDepth(imageID));
 		setVisible(true);
+		displayChanged();
 	}
 
 	virtual ~GraphObject()
 	{
-		getGraphObjects().erase(this);
+		getGraphObjects().remove(m_registryHandle);
+		displayChanged();
 	}
 
 	void setVisible(bool shouldIDisplay)
 	{
+		if (m_visible != shouldIDisplay)
+			displayChanged();
 		m_visible = shouldIDisplay;
 	}
 
@@ -63,6 +176,7 @@ class GraphObject
 		m_destX = x;
 		m_destY = y;
 		increaseAnimationNumber();
+		displayChanged();
 	}
 
 	virtual void moveAngle(int angle, int units = 1)
@@ -96,12 +210,15 @@ class GraphObject
 		while (d < 0)
 			d += 360;
 
+		if (m_direction != d % 360)
+			displayChanged();
 		m_direction = d % 360;
 	}
 
 	void setSize(double size)
 	{
 		m_size = size;
+		displayChanged();
 	}
 
 	double getSize() const
@@ -146,15 +263,16 @@ class GraphObject
 		//moveALittle(m_y, m_destY);
 	}
 
-	static std::set<GraphObject*>& getGraphObjects()
+	static GraphObjectRegistry& getGraphObjects()
 	{
-		static std::set<GraphObject*> graphObjects;
+		static GraphObjectRegistry graphObjects;
 		return graphObjects;
 	}
 
 	void increaseAnimationNumber()
 	{
 		m_animationNumber++;
+		displayChanged();
 	}
 
 
@@ -165,12 +283,75 @@ private:
 		return m_imageID;
 	}
 
+	  // Display depth of each image ID, filled in by the GameController before any
+	  // objects are created; an object is put in its depth's bucket when it's constructed.
+	static int* imageDepths()
+	{
+		static int depths[NUM_IMAGE_IDS];  // indexed by image ID; zero until GameController sets them
+		return depths;
+	}
+
+	static void setImageDepth(int imageID, int depth)
+	{
+		assert(imageID >= 0 && imageID < NUM_IMAGE_IDS);
+		imageDepths()[imageID] = depth;
+	}
+
+	static int getImageDepth(int imageID)
+	{
+		assert(imageID >= 0 && imageID < NUM_IMAGE_IDS);
+		return imageDepths()[imageID];
+	}
+
+	  // Images whose objects never move on their own (walls, factories, pits), also
+	  // filled in by the GameController.  The controller draws those objects into a
+	  // cached background layer, and redraws the layer only when the version changes,
+	  // i.e., when one of them is created, destroyed, moved, turned, resized, or shown
+	  // or hidden.
+	static bool* staticImages()
+	{
+		static bool isStatic[NUM_IMAGE_IDS];
+		return isStatic;
+	}
+
+	static void setImageStatic(int imageID, bool isStatic)
+	{
+		assert(imageID >= 0 && imageID < NUM_IMAGE_IDS);
+		staticImages()[imageID] = isStatic;
+	}
+
+	bool isStaticImage() const
+	{
+		return staticImages()[m_imageID];
+	}
+
+	static unsigned int& staticLayerVersion()
+	{
+		static unsigned int version;
+		return version;
+	}
+
+	  // Set whenever anything the GameController draws for some object changes; the
+	  // controller clears it after drawing and skips drawing frames where it's still clear.
+	static bool& sceneChanged()
+	{
+		static bool changed = true;
+		return changed;
+	}
+
+	void displayChanged()
+	{
+		sceneChanged() = true;
+		if (isStaticImage())
+			staticLayerVersion()++;
+	}
+
   private:
 	  // Prevent copying or assigning GraphObjects
 	GraphObject(const GraphObject&);
 	GraphObject& operator=(const GraphObject&);
 
-	static const int NUM_DEPTHS = 4;
+	static const int NUM_DEPTHS = GraphObjectRegistry::NUM_DEPTHS;
 	int		m_imageID;
 	bool	m_visible;
 	double	m_x;
@@ -181,6 +362,7 @@ private:
 	int	m_animationNumber;
 	int	m_direction;
 	double	m_size;
+	GraphObjectRegistry::Handle m_registryHandle;
 
 	void moveALittle(double& from, double& to)
 	{
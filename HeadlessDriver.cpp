@@ -0,0 +1,96 @@
+#include "HeadlessDriver.h"
+#include "GameWorld.h"
+#include "GameConstants.h"
+#include <iostream>
+#include <chrono>
+using namespace std;
+
+HeadlessDriver::HeadlessDriver(KeySource* keySource, long long maxTicksPerGame)
+ : m_keySource(keySource), m_maxTicksPerGame(maxTicksPerGame),
+   m_games(0), m_gamesWon(0), m_gamesLost(0), m_gamesUnfinished(0),
+   m_totalTicks(0), m_lastGameTicks(0), m_totalScore(0), m_totalSeconds(0), m_moveSeconds(0)
+{
+}
+
+bool HeadlessDriver::playGame(GameWorld* gw)
+{
+	using Clock = chrono::steady_clock;
+	Clock::time_point gameStart = Clock::now();
+	Clock::duration moveTime = Clock::duration::zero();
+
+	gw->setKeySource(m_keySource);
+
+	bool levelError = false;
+	bool levelLoaded = true;  // between an init and its cleanUp
+	long long ticks = 0;
+	int status = gw->init();
+	while (levelLoaded)
+	{
+		if (status != GWSTATUS_CONTINUE_GAME)
+		{
+			if (status == GWSTATUS_PLAYER_WON)
+				m_gamesWon++;
+			else
+			{
+				levelError = true;
+				m_gamesUnfinished++;
+			}
+			break;
+		}
+		if (gw->quitRequested() || (m_maxTicksPerGame > 0 && ticks == m_maxTicksPerGame))
+		{
+			m_gamesUnfinished++;
+			break;
+		}
+
+		Clock::time_point moveStart = Clock::now();
+		status = gw->move();
+		moveTime += Clock::now() - moveStart;
+		ticks++;
+
+		switch (status)
+		{
+		  case GWSTATUS_PLAYER_DIED:
+			gw->cleanUp();
+			if (gw->isGameOver())
+			{
+				m_gamesLost++;
+				levelLoaded = false;
+			}
+			else
+				status = gw->init();
+			break;
+		  case GWSTATUS_FINISHED_LEVEL:
+			gw->advanceToNextLevel();
+			gw->cleanUp();
+			status = gw->init();  // reports the player won if there are no more levels
+			break;
+		}
+	}
+	if (levelLoaded)
+		gw->cleanUp();  // every init, even a failed one, gets a cleanUp
+
+	m_games++;
+	m_totalTicks += ticks;
+	m_lastGameTicks = ticks;
+	m_totalScore += gw->getScore();
+	m_totalSeconds += chrono::duration<double>(Clock::now() - gameStart).count();
+	m_moveSeconds += chrono::duration<double>(moveTime).count();
+	return !levelError;
+}
+
+void HeadlessDriver::report(ostream& os) const
+{
+	os << "Games: " << m_games << " (" << m_gamesWon << " won, " << m_gamesLost << " lost, "
+	   << m_gamesUnfinished << " unfinished)" << endl;
+	if (m_games > 0)
+		os << "Mean score: " << static_cast<double>(m_totalScore) / m_games << endl;
+	os << "Ticks: " << m_totalTicks << " in " << m_totalSeconds << "s";
+	if (m_totalSeconds > 0)
+		os << " (" << m_totalTicks / m_totalSeconds << " ticks/sec";
+	if (m_moveSeconds > 0)
+		os << ", " << m_totalTicks / m_moveSeconds << " counting only move()";
+	if (m_totalSeconds > 0)
+		os << ")";
+	os << endl;
+}
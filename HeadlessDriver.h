@@ -0,0 +1,71 @@
+#ifndef HEADLESSDRIVER_H_
+#define HEADLESSDRIVER_H_
+
+#include "GameWorld.h"
+#include <iostream>
+#include <random>
+
+// Plays games on a plain loop, with no window, GL context, or sound, taking keys from
+// a KeySource instead of the keyboard.  The world's init, move, and cleanUp are called
+// in the same order GameController calls them, just without the prompts in between.
+
+class HeadlessDriver
+{
+public:
+
+	  // maxTicksPerGame of 0 means a game runs until it's won or lost
+	HeadlessDriver(KeySource* keySource, long long maxTicksPerGame = 0);
+
+	  // Play one game in gw, which must be freshly created; returns false if a level
+	  // couldn't be loaded
+	bool playGame(GameWorld* gw);
+
+	void report(std::ostream& os) const;
+
+	long long lastGameTicks() const
+	{
+		return m_lastGameTicks;
+	}
+
+private:
+	KeySource*	m_keySource;
+	long long	m_maxTicksPerGame;
+	int			m_games;
+	int			m_gamesWon;
+	int			m_gamesLost;
+	int			m_gamesUnfinished;  // hit the tick limit or the player quit
+	long long	m_totalTicks;
+	long long	m_lastGameTicks;
+	long long	m_totalScore;
+	double		m_totalSeconds;
+	double		m_moveSeconds;  // of m_totalSeconds, the part spent in move()
+};
+
+  // Presses a random movement or fire key (or nothing) each time it's asked
+class RandomKeySource : public KeySource
+{
+public:
+	RandomKeySource(unsigned int seed)
+	 : m_rng(seed)
+	{
+	}
+
+	virtual bool getKey(int& value)
+	{
+		static const int keys[] = {
+			KEY_PRESS_LEFT, KEY_PRESS_RIGHT, KEY_PRESS_UP, KEY_PRESS_DOWN, KEY_PRESS_SPACE
+		};
+		const int numKeys = sizeof(keys) / sizeof(keys[0]);
+		std::uniform_int_distribution<int> choice(0, 2 * numKeys - 1);  // no key half the time
+		int k = choice(m_rng);
+		if (k >= numKeys)
+			return false;
+		value = keys[k];
+		return true;
+	}
+
+private:
+	std::minstd_rand m_rng;
+};
+
+#endif // HEADLESSDRIVER_H_
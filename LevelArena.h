@@ -0,0 +1,142 @@
+#ifndef LEVELARENA_H_
+#define LEVELARENA_H_
+
+#include <vector>
+#include <new>
+#include <cstddef>
+
+// Memory for the objects of one level.  Allocation bumps a pointer through a list of
+// chunks; an object destroyed mid-level puts its slot on a free list for its size so
+// the next object of that size reuses it.  reset() forgets everything at once and keeps
+// the chunks, so restarting or loading a level doesn't go back to the heap.
+//
+// reset() does not run destructors: destroy (or explicitly destruct) live objects first.
+
+class LevelArena
+{
+public:
+
+	LevelArena(std::size_t chunkSize = 64 * 1024)
+	 : m_chunkSize(chunkSize), m_curChunk(0), m_offset(0)
+	{
+	}
+
+	~LevelArena()
+	{
+		for (std::size_t k = 0; k < m_chunks.size(); k++)
+			::operator delete(m_chunks[k].memory);
+	}
+
+	template<typename T, typename... Args>
+	T* create(Args... args)
+	{
+		return new (allocate(sizeof(T))) T(args...);
+	}
+
+	  // T's destructor must be virtual if object's dynamic type may differ from T
+	template<typename T>
+	void destroy(T* object)
+	{
+		object->~T();
+		release(object);
+	}
+
+	void* allocate(std::size_t size)
+	{
+		std::size_t slotSize = roundUp(size);
+		std::vector<void*>& freeList = freeListFor(slotSize);
+		if (!freeList.empty())
+		{
+			void* slot = freeList.back();
+			freeList.pop_back();
+			return slot;
+		}
+
+		std::size_t needed = HEADER_SIZE + slotSize;
+		while (m_curChunk < m_chunks.size() && m_offset + needed > m_chunks[m_curChunk].size)
+		{
+			m_curChunk++;
+			m_offset = 0;
+		}
+		if (m_curChunk == m_chunks.size())
+		{
+			Chunk chunk;
+			chunk.size = (needed > m_chunkSize ? needed : m_chunkSize);
+			chunk.memory = static_cast<char*>(::operator new(chunk.size));
+			m_chunks.push_back(chunk);
+			m_offset = 0;
+		}
+
+		char* header = m_chunks[m_curChunk].memory + m_offset;
+		m_offset += needed;
+		*reinterpret_cast<std::size_t*>(header) = slotSize;
+		return header + HEADER_SIZE;
+	}
+
+	void release(void* p)
+	{
+		std::size_t slotSize = *reinterpret_cast<std::size_t*>(static_cast<char*>(p) - HEADER_SIZE);
+		freeListFor(slotSize).push_back(p);
+	}
+
+	void reset()
+	{
+		m_curChunk = 0;
+		m_offset = 0;
+		for (std::size_t k = 0; k < m_freeLists.size(); k++)
+			m_freeLists[k].slots.clear();
+	}
+
+	std::size_t bytesReserved() const
+	{
+		std::size_t total = 0;
+		for (std::size_t k = 0; k < m_chunks.size(); k++)
+			total += m_chunks[k].size;
+		return total;
+	}
+
+private:
+	  // Prevent copying or assigning LevelArenas
+	LevelArena(const LevelArena&);
+	LevelArena& operator=(const LevelArena&);
+
+	struct Chunk
+	{
+		char*		memory;
+		std::size_t	size;
+	};
+
+	struct FreeList
+	{
+		std::size_t			slotSize;
+		std::vector<void*>	slots;
+	};
+
+	  // each slot is preceded by its size, padded to keep the object maximally aligned
+	static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+	static const std::size_t HEADER_SIZE = (sizeof(std::size_t) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+	std::size_t				m_chunkSize;
+	std::vector<Chunk>		m_chunks;
+	std::size_t				m_curChunk;
+	std::size_t				m_offset;
+	std::vector<FreeList>	m_freeLists;  // one per slot size; a level only has a handful
+
+	static std::size_t roundUp(std::size_t size)
+	{
+		return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+
+	std::vector<void*>& freeListFor(std::size_t slotSize)
+	{
+		for (std::size_t k = 0; k < m_freeLists.size(); k++)
+			if (m_freeLists[k].slotSize == slotSize)
+				return m_freeLists[k].slots;
+		FreeList list;
+		list.slotSize = slotSize;
+		m_freeLists.push_back(list);
+		return m_freeLists.back().slots;
+	}
+};
+
+#endif // LEVELARENA_H_
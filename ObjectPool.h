@@ -0,0 +1,75 @@
+#ifndef OBJECTPOOL_H_
+#define OBJECTPOOL_H_
+
+#include <vector>
+#include <new>
+#include <cstddef>
+
+// A growable pool of slots for objects of type T.  Slots are carved out of chunks
+// that are only given back when the pool itself is destroyed, so once the pool has
+// grown to its high-water mark, create() and destroy() never touch the heap.
+
+template<typename T>
+class ObjectPool
+{
+public:
+
+	ObjectPool(std::size_t slotsPerChunk = 64)
+	 : m_slotsPerChunk(slotsPerChunk > 0 ? slotsPerChunk : 1)
+	{
+	}
+
+	~ObjectPool()
+	{
+		  // every object must have been destroyed by now; only the raw chunks are left
+		for (std::size_t k = 0; k < m_chunks.size(); k++)
+			::operator delete(m_chunks[k]);
+	}
+
+	template<typename... Args>
+	T* create(Args... args)
+	{
+		if (m_freeSlots.empty())
+			grow();
+		void* slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+		return new (slot) T(args...);
+	}
+
+	void destroy(T* object)
+	{
+		object->~T();
+		m_freeSlots.push_back(object);
+	}
+
+	std::size_t capacity() const
+	{
+		return m_chunks.size() * m_slotsPerChunk;
+	}
+
+	std::size_t available() const
+	{
+		return m_freeSlots.size();
+	}
+
+private:
+	  // Prevent copying or assigning ObjectPools
+	ObjectPool(const ObjectPool&);
+	ObjectPool& operator=(const ObjectPool&);
+
+	std::size_t			m_slotsPerChunk;
+	std::vector<char*>	m_chunks;
+	std::vector<void*>	m_freeSlots;
+
+	void grow()
+	{
+		char* chunk = static_cast<char*>(::operator new(m_slotsPerChunk * sizeof(T)));
+		m_chunks.push_back(chunk);
+		m_freeSlots.reserve(capacity());
+		  // push in reverse so slots are handed out from the start of the chunk
+		for (std::size_t k = m_slotsPerChunk; k-- > 0; )
+			m_freeSlots.push_back(chunk + k * sizeof(T));
+	}
+};
+
+#endif // OBJECTPOOL_H_
@@ -0,0 +1,107 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <cstdint>
+#include <random>
+#include <utility>
+
+// A small, fast random number generator (xoshiro256**).  Each GameWorld owns one, so
+// worlds don't share state and a world seeded with the same number replays the same
+// way.  randInt draws bounded values without modulo bias using Lemire's
+// multiply-and-reject method.
+
+class Random
+{
+public:
+
+	  // Seeded from the system's entropy source
+	Random()
+	{
+		std::random_device rd;
+		seed((static_cast<std::uint64_t>(rd()) << 32) | rd());
+	}
+
+	explicit Random(std::uint64_t s)
+	{
+		seed(s);
+	}
+
+	  // Expand the seed into the full state with splitmix64, as xoshiro's authors advise
+	void seed(std::uint64_t s)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			s += 0x9e3779b97f4a7c15ULL;
+			std::uint64_t z = s;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+			m_state[k] = z ^ (z >> 31);
+		}
+	}
+
+	  // The generator's whole state, e.g., to save it in a snapshot and restore it later
+	void getState(std::uint64_t state[4]) const
+	{
+		for (int k = 0; k < 4; k++)
+			state[k] = m_state[k];
+	}
+
+	void setState(const std::uint64_t state[4])
+	{
+		for (int k = 0; k < 4; k++)
+			m_state[k] = state[k];
+		if ((m_state[0] | m_state[1] | m_state[2] | m_state[3]) == 0)
+			seed(0);  // all zeros is the one state xoshiro can never leave
+	}
+
+	std::uint64_t next()
+	{
+		std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+		std::uint64_t t = m_state[1] << 17;
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = rotl(m_state[3], 45);
+		return result;
+	}
+
+	  // Return a uniformly distributed random int from min to max, inclusive
+	int randInt(int min, int max)
+	{
+		if (max < min)
+			std::swap(max, min);
+		std::uint32_t range = static_cast<std::uint32_t>(static_cast<std::int64_t>(max) - min) + 1;
+		if (range == 0)  // min to max covers every int
+			return static_cast<int>(static_cast<std::uint32_t>(next() >> 32));
+		return static_cast<int>(static_cast<std::int64_t>(min) + bounded(range));
+	}
+
+private:
+	std::uint64_t m_state[4];
+
+	static std::uint64_t rotl(std::uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	  // A uniform value in [0, range), range > 0
+	std::uint32_t bounded(std::uint32_t range)
+	{
+		std::uint64_t m = static_cast<std::uint64_t>(static_cast<std::uint32_t>(next() >> 32)) * range;
+		std::uint32_t low = static_cast<std::uint32_t>(m);
+		if (low < range)
+		{
+			std::uint32_t threshold = (0u - range) % range;
+			while (low < threshold)
+			{
+				m = static_cast<std::uint64_t>(static_cast<std::uint32_t>(next() >> 32)) * range;
+				low = static_cast<std::uint32_t>(m);
+			}
+		}
+		return static_cast<std::uint32_t>(m >> 32);
+	}
+};
+
+#endif // RANDOM_H_
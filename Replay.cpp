@@ -0,0 +1,173 @@
+#include "Replay.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+using namespace std;
+
+static const char MAGIC[4] = { 'M', 'M', 'R', 'P' };
+
+static void writeVarint(string& out, uint64_t n)
+{
+	while (n >= 0x80)
+	{
+		out += static_cast<char>((n & 0x7f) | 0x80);
+		n >>= 7;
+	}
+	out += static_cast<char>(n);
+}
+
+static bool readVarint(istream& in, uint64_t& n)
+{
+	n = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		char c;
+		if (!in.get(c))
+			return false;
+		n |= static_cast<uint64_t>(static_cast<unsigned char>(c) & 0x7f) << shift;
+		if ((static_cast<unsigned char>(c) & 0x80) == 0)
+			return true;
+	}
+	return false;  // too long to be a varint we wrote
+}
+
+Replay::Replay()
+ : m_seed(0), m_levelHash(0), m_ticks(0), m_cursor(0), m_servedInRun(0)
+{
+}
+
+void Replay::startRecording(uint64_t seed, uint64_t levelHash)
+{
+	m_seed = seed;
+	m_levelHash = levelHash;
+	m_ticks = 0;
+	m_runs.clear();
+	rewind();
+}
+
+void Replay::recordKey(bool gotKey, int value)
+{
+	uint32_t key = (gotKey ? static_cast<uint32_t>(value) + 1 : NO_KEY);
+	if (!m_runs.empty() && m_runs.back().key == key)
+		m_runs.back().count++;
+	else
+	{
+		Run run = { key, 1 };
+		m_runs.push_back(run);
+	}
+}
+
+void Replay::rewind()
+{
+	m_cursor = 0;
+	m_servedInRun = 0;
+}
+
+bool Replay::getKey(int& value)
+{
+	if (finished())
+		return false;  // past the end of the recording: nobody's pressing anything
+
+	const Run& run = m_runs[m_cursor];
+	if (++m_servedInRun == run.count)
+	{
+		m_cursor++;
+		m_servedInRun = 0;
+	}
+	if (run.key == NO_KEY)
+		return false;
+	value = static_cast<int>(run.key - 1);
+	return true;
+}
+
+  // Layout: "MMRP", then varints for the format version, seed, level hash, tick count,
+  // and number of runs, then each run's key and count as varints.
+bool Replay::save(const string& filename) const
+{
+	string out(MAGIC, sizeof(MAGIC));
+	writeVarint(out, FORMAT_VERSION);
+	writeVarint(out, m_seed);
+	writeVarint(out, m_levelHash);
+	writeVarint(out, static_cast<uint64_t>(m_ticks));
+	writeVarint(out, m_runs.size());
+	for (const Run& run : m_runs)
+	{
+		writeVarint(out, run.key);
+		writeVarint(out, run.count);
+	}
+
+	ofstream file(filename, ios::out | ios::binary);
+	if (!file)
+	{
+		cerr << "***** Unable to create replay file " << filename << endl;
+		return false;
+	}
+	file.write(out.data(), out.size());
+	return static_cast<bool>(file);
+}
+
+bool Replay::load(const string& filename)
+{
+	ifstream file(filename, ios::in | ios::binary);
+	if (!file)
+	{
+		cerr << "***** Unable to open replay file " << filename << endl;
+		return false;
+	}
+
+	char magic[sizeof(MAGIC)];
+	uint64_t version, ticks, numRuns;
+	if (!file.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), MAGIC)  ||
+		!readVarint(file, version) || version != FORMAT_VERSION  ||
+		!readVarint(file, m_seed) || !readVarint(file, m_levelHash)  ||
+		!readVarint(file, ticks) || !readVarint(file, numRuns))
+	{
+		cerr << "***** " << filename << " is not a replay file this version can play" << endl;
+		return false;
+	}
+	m_ticks = static_cast<long long>(ticks);
+
+	m_runs.clear();
+	for (uint64_t k = 0; k < numRuns; k++)
+	{
+		uint64_t key, count;
+		if (!readVarint(file, key) || !readVarint(file, count) || count == 0)
+		{
+			cerr << "***** Replay file " << filename << " is truncated or corrupt" << endl;
+			return false;
+		}
+		Run run = { static_cast<uint32_t>(key), count };
+		m_runs.push_back(run);
+	}
+
+	rewind();
+	return true;
+}
+
+uint64_t Replay::hashLevelFiles(const string& assetPath)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	string prefix = assetPath;
+	if (!prefix.empty())
+		prefix += '/';  // the same way Level builds its path
+
+	for (int level = 0; level <= 99; level++)
+	{
+		ostringstream oss;
+		oss << "level" << setw(2) << setfill('0') << level << ".txt";
+		ifstream file(prefix + oss.str(), ios::in | ios::binary);
+		if (!file)
+			break;  // levels are numbered consecutively from level00
+
+		  // fold in the level number too, so renumbering levels changes the hash
+		const string name = oss.str();
+		for (char c : name)
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+		char c;
+		while (file.get(c))
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+	}
+	return hash;
+}
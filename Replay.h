@@ -0,0 +1,82 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "GameWorld.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// A recorded game: the random seed the world was given, a hash of the level files it
+// was played on, how many ticks it ran, and the answer to every key request the world
+// made.  Since a world's play depends only on those, playing the keys back into a
+// world with the same seed and levels repeats the game exactly.
+//
+// While recording, a Replay is told about each key request; for playback, it serves
+// the recorded answers as a KeySource.  Consecutive identical answers (mostly "no key")
+// are stored as one run, and numbers are stored as varints, so files stay small.
+
+class Replay : public KeySource, public KeyRecorder
+{
+public:
+
+	Replay();
+
+	  // Start a new recording
+	void startRecording(std::uint64_t seed, std::uint64_t levelHash);
+	virtual void recordKey(bool gotKey, int value);
+	void setTicks(long long ticks)
+	{
+		m_ticks = ticks;
+	}
+
+	bool save(const std::string& filename) const;
+	bool load(const std::string& filename);
+
+	  // Serve the recorded keys from the start
+	void rewind();
+	virtual bool getKey(int& value);
+
+	  // All recorded key requests have been served
+	bool finished() const
+	{
+		return m_cursor == m_runs.size();
+	}
+
+	std::uint64_t seed() const
+	{
+		return m_seed;
+	}
+
+	std::uint64_t levelHash() const
+	{
+		return m_levelHash;
+	}
+
+	long long ticks() const
+	{
+		return m_ticks;
+	}
+
+	  // FNV-1a hash of the level files level00.txt, level01.txt, ... in assetPath
+	static std::uint64_t hashLevelFiles(const std::string& assetPath);
+
+private:
+	  // count consecutive requests all answered with key (NO_KEY if there was none)
+	struct Run
+	{
+		std::uint32_t	key;
+		std::uint64_t	count;
+	};
+
+	static const std::uint32_t NO_KEY = 0;  // keys are stored as value+1
+	static const std::uint32_t FORMAT_VERSION = 1;
+
+	std::uint64_t		m_seed;
+	std::uint64_t		m_levelHash;
+	long long			m_ticks;
+	std::vector<Run>	m_runs;
+	std::size_t			m_cursor;		// playback position: run, and requests served from it
+	std::uint64_t		m_servedInRun;
+};
+
+#endif // REPLAY_H_
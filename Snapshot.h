@@ -0,0 +1,146 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Byte-level encoding for world snapshots.  Small non-negative numbers are written as
+// varints (7 bits per byte, low bits first), signed ones zigzag-encoded first so small
+// negative numbers stay small too, and raw 64-bit words as 8 little-endian bytes.
+// A writer appends to a caller's buffer, so reusing one buffer for snapshot after
+// snapshot doesn't allocate once it has grown.
+
+class SnapshotWriter
+{
+public:
+
+	explicit SnapshotWriter(std::string& buffer)
+	 : m_buffer(buffer)
+	{
+	}
+
+	void putByte(unsigned int b)
+	{
+		m_buffer += static_cast<char>(b);
+	}
+
+	void putBytes(const char* bytes, std::size_t n)
+	{
+		m_buffer.append(bytes, n);
+	}
+
+	void putVarint(std::uint64_t n)
+	{
+		while (n >= 0x80)
+		{
+			m_buffer += static_cast<char>((n & 0x7f) | 0x80);
+			n >>= 7;
+		}
+		m_buffer += static_cast<char>(n);
+	}
+
+	void putInt(int n)
+	{
+		std::uint64_t u = static_cast<std::uint64_t>(static_cast<std::int64_t>(n));
+		putVarint((u << 1) ^ (n < 0 ? ~std::uint64_t(0) : 0));
+	}
+
+	void putBool(bool b)
+	{
+		putByte(b ? 1 : 0);
+	}
+
+	void putWord(std::uint64_t w)
+	{
+		for (int k = 0; k < 8; k++)
+			m_buffer += static_cast<char>((w >> (8 * k)) & 0xff);
+	}
+
+private:
+	std::string& m_buffer;
+};
+
+  // Reads what a SnapshotWriter wrote.  Reading past the end, or a malformed varint,
+  // yields zeros and sets failed(), so a caller can read a whole record and check once.
+class SnapshotReader
+{
+public:
+
+	SnapshotReader(const std::string& data)
+	 : m_data(data), m_pos(0), m_failed(false)
+	{
+	}
+
+	unsigned int getByte()
+	{
+		if (m_pos >= m_data.size())
+		{
+			m_failed = true;
+			return 0;
+		}
+		return static_cast<unsigned char>(m_data[m_pos++]);
+	}
+
+	  // True if the next n bytes match bytes (and consumes them)
+	bool matchBytes(const char* bytes, std::size_t n)
+	{
+		if (m_data.size() - m_pos < n || m_data.compare(m_pos, n, bytes, n) != 0)
+		{
+			m_failed = true;
+			return false;
+		}
+		m_pos += n;
+		return true;
+	}
+
+	std::uint64_t getVarint()
+	{
+		std::uint64_t n = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			unsigned int b = getByte();
+			n |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+			if ((b & 0x80) == 0)
+				return n;
+		}
+		m_failed = true;  // too long to be a varint we wrote
+		return 0;
+	}
+
+	int getInt()
+	{
+		std::uint64_t u = getVarint();
+		return static_cast<int>(static_cast<std::int64_t>(u >> 1) ^ -static_cast<std::int64_t>(u & 1));
+	}
+
+	bool getBool()
+	{
+		return getByte() != 0;
+	}
+
+	std::uint64_t getWord()
+	{
+		std::uint64_t w = 0;
+		for (int k = 0; k < 8; k++)
+			w |= static_cast<std::uint64_t>(getByte()) << (8 * k);
+		return w;
+	}
+
+	bool failed() const
+	{
+		return m_failed;
+	}
+
+	bool atEnd() const
+	{
+		return m_pos == m_data.size();
+	}
+
+private:
+	const std::string&	m_data;
+	std::size_t			m_pos;
+	bool				m_failed;
+};
+
+#endif // SNAPSHOT_H_
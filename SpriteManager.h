@@ -16,23 +16,34 @@
 #define GL_BGRA GL_BGRA_EXT
 #endif
 
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
 #include "GameConstants.h"
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <map>
+#include <vector>
 #include <memory>
 #include <algorithm>
 #include <cstring>
 #include <cmath>
+#include <cassert>
 
 class SpriteManager
 {
 public:
 
 	SpriteManager()
-	 : m_mipMapped(true)
+	 : m_mipMapped(true), m_boundTexture(0), m_queuedSprites(0)
 	{
+		std::fill(m_imageLoaded, m_imageLoaded + MAX_SPRITES, false);
+		std::fill(m_frameCountPerSprite, m_frameCountPerSprite + MAX_IMAGES, 0);
+		const int tabledAngles[NUM_TABLED_ANGLES] = { 0, 90, 180, 270, -1 };
+		for (int k = 0; k < NUM_TABLED_ANGLES; k++)
+			getCorners(tabledAngles[k], 1.0, m_cornerTable[k].x, m_cornerTable[k].y);
+		beginFrame();
 	}
 
 	void setMipMapping(bool status)
@@ -96,172 +107,253 @@ public:
 		if (header.image_descriptor & 0x20)  // image ios flipped vertically
 	  		flipVertical(imageData.get(),header.width_pixels,header.height_pixels,byteCount);
 
-		// Transfer Texture To OpenGL
-
-		glEnable(GL_DEPTH_TEST);
-
-		  // allocate a texture handle
-		GLuint glTextureID;
-		glGenTextures(1, &glTextureID);
-
-		  // bind our new texture
-		glBindTexture(GL_TEXTURE_2D, glTextureID);
-
-		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		  // Keep the pixels, as BGRA, until buildAtlases packs them into a shared texture
 
-		if (m_mipMapped)
+		PendingImage image;
+		image.spriteID = spriteID;
+		image.width = textureWidth;
+		image.height = textureHeight;
+		image.pixels.resize(textureWidth * textureHeight * 4);
+		for (unsigned int k = 0; k < textureWidth * textureHeight; k++)
 		{
-			  // when texture area is small, bilinear filter the closest mipmap
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			  // when texture area is large, bilinear filter the first mipmap
-			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		}
-		else
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			const char* from = imageData.get() + k * byteCount;
+			std::memcpy(&image.pixels[k * 4], from, 3);
+			image.pixels[k * 4 + 3] = (byteCount == 4 ? from[3] : static_cast<char>(0xff));
 		}
+		m_pendingImages.push_back(std::move(image));
 
-		  // Have the texture wrap both vertically and horizontally.
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLfloat>(GL_REPEAT));
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLfloat>(GL_REPEAT));
+		return true;
+	}
 
-		if (m_mipMapped)
+	  // Pack every sprite loaded since the last call into as few atlas textures as the
+	  // driver's maximum texture size allows, so a frame needs only a texture bind or two.
+	  // Each frame gets a gutter of its own edge pixels so neighbours don't bleed into it
+	  // when it's filtered or mipmapped.
+	bool buildAtlases()
+	{
+		if (m_pendingImages.empty())
+			return true;
+
+		GLint maxTextureSize = 0;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+		  // never larger than the driver allows; pages are powers of 2, so round its limit down
+		unsigned int maxPageSize = MAX_ATLAS_SIZE;
+		while (maxTextureSize > 0 && static_cast<unsigned int>(maxTextureSize) < maxPageSize)
+			maxPageSize /= 2;
+
+		  // don't make the page any wider than a square that could hold all of the frames
+		unsigned long long totalArea = 0;
+		unsigned int widest = 0;
+		for (auto& image : m_pendingImages)
 		{
-			  // build our texture mipmaps
-			  // byteCount of 3 means that BGR data is being supplied. byteCount of 4 means that BGRA data is being supplied.
-			makeMipmaps(byteCount, textureWidth, textureHeight, imageData.get());
+			totalArea += static_cast<unsigned long long>(image.width + 2 * ATLAS_PADDING) * (image.height + 2 * ATLAS_PADDING);
+			widest = std::max(widest, image.width + 2 * ATLAS_PADDING);
 		}
-		else
+		unsigned int pageSize = roundUpToPowerOf2(widest);
+		while (pageSize < maxPageSize && static_cast<unsigned long long>(pageSize) * pageSize < totalArea)
+			pageSize *= 2;
+		pageSize = std::min(pageSize, maxPageSize);
+
+		  // tallest first packs shelves tightly
+		std::vector<PendingImage*> order;
+		for (auto& image : m_pendingImages)
+			order.push_back(&image);
+		std::stable_sort(order.begin(), order.end(),
+			[](const PendingImage* a, const PendingImage* b) { return a->height > b->height; });
+
+		size_t next = 0;
+		while (next < order.size())
 		{
-			  // byteCount of 3 means that BGR data is being supplied. byteCount of 4 means that BGRA data is being supplied.
-			if (3 == byteCount)
-				glTexImage2D(GL_TEXTURE_2D, 0, 3, textureWidth, textureHeight, 0, GL_BGR, GL_UNSIGNED_BYTE, imageData.get());
-			else if (4 == byteCount)
-				glTexImage2D(GL_TEXTURE_2D, 0, 4, textureWidth, textureHeight, 0, GL_BGRA, GL_UNSIGNED_BYTE, imageData.get());
+			  // place images shelf by shelf until the page is full
+			std::vector<Placement> placed;
+			unsigned int shelfX = 0, shelfY = 0, shelfHeight = 0;
+			for ( ; next < order.size(); next++)
+			{
+				PendingImage* image = order[next];
+				unsigned int w = image->width + 2 * ATLAS_PADDING;
+				unsigned int h = image->height + 2 * ATLAS_PADDING;
+				if (w > pageSize || h > pageSize)
+				{
+					std::cerr << "***** Sprite too large for a " << pageSize << " pixel atlas" << std::endl;
+					return false;
+				}
+				if (shelfX + w > pageSize)
+				{
+					shelfY += shelfHeight;
+					shelfX = 0;
+					shelfHeight = 0;
+				}
+				if (shelfY + h > pageSize)
+					break;  // page is full; the rest go on the next one
+				Placement p = { image, shelfX + ATLAS_PADDING, shelfY + ATLAS_PADDING };
+				placed.push_back(p);
+				shelfX += w;
+				shelfHeight = std::max(shelfHeight, h);
+			}
+
+			unsigned int atlasWidth = roundUpToPowerOf2(placed.size() == 1 ? placed[0].image->width + 2 * ATLAS_PADDING : pageSize);
+			unsigned int atlasHeight = roundUpToPowerOf2(shelfY + shelfHeight);
+			std::vector<char> pixels(atlasWidth * atlasHeight * 4, 0);
+			for (auto& p : placed)
+				blitWithGutter(pixels, atlasWidth, atlasHeight, *p.image, p.x, p.y);
+
+			GLuint glTextureID = uploadTexture(atlasWidth, atlasHeight, pixels.data());
+			m_atlasTextures.push_back(glTextureID);
+
+			for (auto& p : placed)
+			{
+				SpriteRect rect;
+				rect.texture = glTextureID;
+				rect.u0 = static_cast<GLfloat>(p.x) / atlasWidth;
+				rect.v0 = static_cast<GLfloat>(p.y) / atlasHeight;
+				rect.u1 = static_cast<GLfloat>(p.x + p.image->width) / atlasWidth;
+				rect.v1 = static_cast<GLfloat>(p.y + p.image->height) / atlasHeight;
+				m_imageMap[p.image->spriteID] = rect;
+				m_imageLoaded[p.image->spriteID] = true;
+			}
 		}
 
-		m_imageMap[spriteID] = glTextureID;
-
+		m_pendingImages.clear();
 		return true;
 	}
 
 	int getNumFrames(int imageID) const
 	{
-		auto it = m_frameCountPerSprite.find(imageID);
-		if (it == m_frameCountPerSprite.end())
-			return 0;
+		assert(imageID >= 0 && imageID < MAX_IMAGES);
+		return m_frameCountPerSprite[imageID];
+	}
 
-		return it->second;
+
+	  // Per-frame counters filled in by queueSprite and flush
+	struct FrameStats
+	{
+		int sprites;
+		int drawCalls;
+		int stateChanges;
+	};
+
+	  // Start a new frame: forget anything still queued and zero the frame's stats.
+	  // Anyone binding other textures between flushes must call textureChanged afterwards.
+	void beginFrame()
+	{
+		for (auto& batch : m_batches)
+			batch.clear();
+		m_queuedSprites = 0;
+		m_boundTexture = 0;
+		m_frameStats.sprites = 0;
+		m_frameStats.drawCalls = 0;
+		m_frameStats.stateChanges = 0;
 	}
 
+	  // Call after anything else may have bound a texture (e.g., a display list was
+	  // played or compiled), so the next flush binds its own.
+	void textureChanged()
+	{
+		m_boundTexture = 0;
+	}
 
-	bool plotSprite(int imageID, int frame, double gx, double gy, double gz, int angleDegrees, double size)
+	  // Queue a sprite to be drawn by the next flush.  Sprites that share a texture are
+	  // drawn together, so only the order of flushes (not of sprites within one) is kept.
+	bool queueSprite(int imageID, int frame, double gx, double gy, double gz, int angleDegrees, double size)
 	{
 		int spriteID = getSpriteID(imageID,frame);
-		if (INVALID_SPRITE_ID == spriteID)
+		if (INVALID_SPRITE_ID == spriteID || !m_imageLoaded[spriteID])
 			return false;
 
-		auto it = m_imageMap.find(spriteID);
-		if (it == m_imageMap.end())
-			return false;
+		double rx[4], ry[4];
+		const QuadCorners* corners = tabledCorners(angleDegrees);
+		if (corners != nullptr)
+		{
+			for (int k = 0; k < 4; k++)
+			{
+				rx[k] = corners->x[k] * size;
+				ry[k] = corners->y[k] * size;
+			}
+		}
+		else
+			getCorners(angleDegrees, size, rx, ry);
 
-		double finalWidth, finalHeight;
+		const SpriteRect& rect = m_imageMap[spriteID];
+		const GLfloat cx[4] = { rect.u0, rect.u1, rect.u1, rect.u0 };
+		const GLfloat cy[4] = { rect.v0, rect.v0, rect.v1, rect.v1 };
 
-		finalWidth = SPRITE_WIDTH_GL * size;
-		finalHeight = SPRITE_HEIGHT_GL * size;
+		Batch& batch = batchFor(rect.texture);
+		for (int k = 0; k < 4; k++)
+		{
+			  // object's x/y location is center-based; the corners are relative to it
+			batch.vertices.push_back(static_cast<GLfloat>(gx) + static_cast<GLfloat>(rx[k]));
+			batch.vertices.push_back(static_cast<GLfloat>(gy) + static_cast<GLfloat>(ry[k]));
+			batch.vertices.push_back(static_cast<GLfloat>(gz));
+			batch.texCoords.push_back(cx[k]);
+			batch.texCoords.push_back(cy[k]);
+		}
+		m_queuedSprites++;
+		m_frameStats.sprites++;
+		return true;
+	}
 
-		// object's x/y location is center-based, but sprite plotting is upper-left-corner based
-		const double xoffset = 0;// finalWidth / 2;
-		const double yoffset = 0;// finalHeight / 2;
+	  // Draw everything queued since the last flush, one draw call per texture.
+	void flush()
+	{
+		if (m_queuedSprites == 0)
+			return;
 
-		glPushMatrix();
-		glTranslatef(static_cast<GLfloat>(gx-xoffset),static_cast<GLfloat>(gy-yoffset),static_cast<GLfloat>(gz));
 		glPushAttrib(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glEnable(GL_TEXTURE_2D);
-		glDisable(GL_DEPTH_TEST);
-		glEnable (GL_BLEND);
+		setEnabled(GL_TEXTURE_2D, true);
+		setEnabled(GL_DEPTH_TEST, false);
+		setEnabled(GL_BLEND, true);
 		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		glBindTexture(GL_TEXTURE_2D, it->second);
-
+		m_frameStats.stateChanges++;
+		setClientStateEnabled(GL_VERTEX_ARRAY, true);
+		setClientStateEnabled(GL_TEXTURE_COORD_ARRAY, true);
 		glColor3f(1.0, 1.0, 1.0);
+		m_frameStats.stateChanges++;
 
-		double cx1,cx2,cx3,cx4;
-		double cy1,cy2,cy3,cy4;
-
-		cx1 = cy1 = 0;
-		cx2 = 1; cy2 = 0;
-		cx3 = 1; cy3 = 1;
-		cx4 = 0; cy4 = 1;
-
-		double rx1, ry1, rx2, ry2, rx3, ry3, rx4, ry4;
-
-//#define FULL_ROTATION	// for games where you can rotate 360 degrees, not just n/s/e/w
-
-#ifndef FULL_ROTATION
-		if (angleDegrees != 180)
+		for (auto& batch : m_batches)
 		{
-			rotate(-finalWidth / 2, -finalHeight / 2, angleDegrees, rx1, ry1);
-			rotate(finalWidth / 2, -finalHeight / 2, angleDegrees, rx2, ry2);
-			rotate(finalWidth / 2, finalHeight / 2, angleDegrees, rx3, ry3);
-			rotate(-finalWidth / 2, finalHeight / 2, angleDegrees, rx4, ry4);
+			if (batch.vertices.empty())
+				continue;
+			if (batch.texture != m_boundTexture)  // with one atlas, once per frame
+			{
+				glBindTexture(GL_TEXTURE_2D, batch.texture);
+				m_boundTexture = batch.texture;
+				m_frameStats.stateChanges++;
+			}
+			glVertexPointer(3, GL_FLOAT, 0, batch.vertices.data());
+			glTexCoordPointer(2, GL_FLOAT, 0, batch.texCoords.data());
+			glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(batch.vertices.size() / 3));
+			m_frameStats.drawCalls++;
+			batch.clear();
 		}
-		else
-		{
-			// Ensure actors rotated to face left aren't upside-down.
-			rotate(-finalWidth / 2, -finalHeight / 2, 0, rx1, ry1);
-			rotate(finalWidth / 2, -finalHeight / 2, 0, rx2, ry2);
-			rotate(finalWidth / 2, finalHeight / 2, 0, rx3, ry3);
-			rotate(-finalWidth / 2, finalHeight / 2, 0, rx4, ry4);
-			std::swap(rx1, rx2);
-			std::swap(rx3, rx4);
-		}
-#else
-		angleDegrees += 90;
-		rotate(-finalWidth / 2, -finalHeight / 2, angleDegrees, rx1, ry1);
-		rotate(finalWidth / 2, -finalHeight / 2, angleDegrees, rx2, ry2);
-		rotate(finalWidth / 2, finalHeight / 2, angleDegrees, rx3, ry3);
-		rotate(-finalWidth / 2, finalHeight / 2, angleDegrees, rx4, ry4);
-#endif  // FULL_ROTATION
 
-		glBegin(GL_QUADS);
-		glTexCoord2d(cx1, cy1);
-		glVertex3f(static_cast<GLfloat>(rx1), static_cast<GLfloat>(ry1), 0);
-		glTexCoord2d(cx2, cy2);
-		glVertex3f(static_cast<GLfloat>(rx2), static_cast<GLfloat>(ry2), 0);
-		glTexCoord2d(cx3, cy3);
-		glVertex3f(static_cast<GLfloat>(rx3), static_cast<GLfloat>(ry3), 0);
-		glTexCoord2d(cx4, cy4);
-		glVertex3f(static_cast<GLfloat>(rx4), static_cast<GLfloat>(ry4), 0);
-		glEnd();
-
-
-		/*
-		glBegin (GL_QUADS);
-		  glTexCoord2d(cx1, cy1);
-		  glVertex3f(0, 0, 0);
-		  glTexCoord2d(cx2, cy2);
-		  glVertex3f(static_cast<GLfloat>(finalWidth), 0, 0);
-		  glTexCoord2d(cx3, cy3);
-		  glVertex3f(static_cast<GLfloat>(finalWidth), static_cast<GLfloat>(finalHeight), 0);
-		  glTexCoord2d(cx4, cy4);
-		  glVertex3f(0, static_cast<GLfloat>(finalHeight), 0);
-		glEnd();
-		*/
-
-		glDisable(GL_TEXTURE_2D);
-		glEnable(GL_DEPTH_TEST);
+		setClientStateEnabled(GL_TEXTURE_COORD_ARRAY, false);
+		setClientStateEnabled(GL_VERTEX_ARRAY, false);
+		setEnabled(GL_TEXTURE_2D, false);
+		glPopAttrib();  // restores blending and the depth test
+		m_frameStats.stateChanges++;
+
+		m_queuedSprites = 0;
+	}
 
-		glPopAttrib();
-		glPopMatrix();
+	const FrameStats& getFrameStats() const
+	{
+		return m_frameStats;
+	}
 
+	  // Draw a single sprite right away.
+	bool plotSprite(int imageID, int frame, double gx, double gy, double gz, int angleDegrees, double size)
+	{
+		flush();
+		if (!queueSprite(imageID, frame, gx, gy, gz, angleDegrees, size))
+			return false;
+		flush();
 		return true;
 	}
 
 	~SpriteManager()
 	{
-		for (auto it = m_imageMap.begin(); it != m_imageMap.end(); it++)
-			glDeleteTextures(1, &it->second);
+		for (auto texture : m_atlasTextures)
+			glDeleteTextures(1, &texture);
 	}
 
 private:
@@ -283,13 +375,151 @@ private:
   };
 #pragma pack()
 
-	bool                  m_mipMapped;
-	std::map<int, GLuint> m_imageMap;
-	std::map<int, int>    m_frameCountPerSprite;
+	  // Quads queued for one texture, as parallel vertex and texture coordinate arrays
+	struct Batch
+	{
+		GLuint               texture;
+		std::vector<GLfloat> vertices;
+		std::vector<GLfloat> texCoords;
+
+		void clear()
+		{
+			vertices.clear();
+			texCoords.clear();
+		}
+	};
+
+	  // Where a sprite frame lives: an atlas texture and the frame's rectangle in it
+	struct SpriteRect
+	{
+		GLuint  texture;
+		GLfloat u0, v0, u1, v1;
+	};
+
+	  // A loaded frame waiting for buildAtlases
+	struct PendingImage
+	{
+		int               spriteID;
+		unsigned int      width;
+		unsigned int      height;
+		std::vector<char> pixels;  // BGRA, bottom row first
+	};
+
+	struct Placement
+	{
+		PendingImage* image;
+		unsigned int  x;
+		unsigned int  y;
+	};
 
 	static const int INVALID_SPRITE_ID = -1;
-	static const int MAX_IMAGES = 1000;
-	static const int MAX_FRAMES_PER_SPRITE = 100;
+	static const int MAX_IMAGES = NUM_IMAGE_IDS;
+	static const int MAX_FRAMES_PER_SPRITE = 8;
+	static const int MAX_SPRITES = MAX_IMAGES * MAX_FRAMES_PER_SPRITE;
+
+	  // Corners of a unit-size sprite for each direction GraphObjects use (-1 is
+	  // GraphObject::none), so plotting one needn't do any trig
+	static const int NUM_TABLED_ANGLES = 5;
+
+	struct QuadCorners
+	{
+		double x[4];
+		double y[4];
+	};
+
+	bool                  m_mipMapped;
+	QuadCorners           m_cornerTable[NUM_TABLED_ANGLES];  // in the order tabledCorners looks them up
+	  // indexed by image ID or sprite ID, so drawing never searches for a sprite
+	SpriteRect            m_imageMap[MAX_SPRITES];
+	bool                  m_imageLoaded[MAX_SPRITES];
+	std::vector<PendingImage> m_pendingImages;
+	std::vector<GLuint>   m_atlasTextures;
+	GLuint                m_boundTexture;
+	int                   m_frameCountPerSprite[MAX_IMAGES];
+	std::vector<Batch>    m_batches;  // one per texture, kept between frames to reuse their storage
+	int                   m_queuedSprites;
+	FrameStats            m_frameStats;
+
+	static const unsigned int MAX_ATLAS_SIZE = 4096;
+	static const unsigned int ATLAS_PADDING = 8;  // gutter around each frame; enough for the first few mip levels
+
+	Batch& batchFor(GLuint texture)
+	{
+		for (auto& batch : m_batches)
+			if (batch.texture == texture)
+				return batch;
+		m_batches.push_back(Batch());
+		m_batches.back().texture = texture;
+		return m_batches.back();
+	}
+
+	  // glEnable or glDisable, counted in the frame's stats
+	void setEnabled(GLenum capability, bool enabled)
+	{
+		if (enabled)
+			glEnable(capability);
+		else
+			glDisable(capability);
+		m_frameStats.stateChanges++;
+	}
+
+	void setClientStateEnabled(GLenum array, bool enabled)
+	{
+		if (enabled)
+			glEnableClientState(array);
+		else
+			glDisableClientState(array);
+		m_frameStats.stateChanges++;
+	}
+
+	  // Precomputed corners of a unit-size quad for a tabled angle, or nullptr
+	const QuadCorners* tabledCorners(int angleDegrees) const
+	{
+		switch (angleDegrees)
+		{
+			case 0:   return &m_cornerTable[0];
+			case 90:  return &m_cornerTable[1];
+			case 180: return &m_cornerTable[2];
+			case 270: return &m_cornerTable[3];
+			case -1:  return &m_cornerTable[4];
+			default:  return nullptr;
+		}
+	}
+
+	  // Corners of a sprite's quad, relative to its center, turned to face angleDegrees
+	void getCorners(int angleDegrees, double size, double rx[4], double ry[4])
+	{
+		double finalWidth = SPRITE_WIDTH_GL * size;
+		double finalHeight = SPRITE_HEIGHT_GL * size;
+
+//#define FULL_ROTATION	// for games where you can rotate 360 degrees, not just n/s/e/w
+
+#ifndef FULL_ROTATION
+		if (angleDegrees != 180)
+		{
+			rotate(-finalWidth / 2, -finalHeight / 2, angleDegrees, rx[0], ry[0]);
+			rotate(finalWidth / 2, -finalHeight / 2, angleDegrees, rx[1], ry[1]);
+			rotate(finalWidth / 2, finalHeight / 2, angleDegrees, rx[2], ry[2]);
+			rotate(-finalWidth / 2, finalHeight / 2, angleDegrees, rx[3], ry[3]);
+		}
+		else
+		{
+			// Ensure actors rotated to face left aren't upside-down.
+			rotate(-finalWidth / 2, -finalHeight / 2, 0, rx[0], ry[0]);
+			rotate(finalWidth / 2, -finalHeight / 2, 0, rx[1], ry[1]);
+			rotate(finalWidth / 2, finalHeight / 2, 0, rx[2], ry[2]);
+			rotate(-finalWidth / 2, finalHeight / 2, 0, rx[3], ry[3]);
+			std::swap(rx[0], rx[1]);
+			std::swap(rx[2], rx[3]);
+		}
+#else
+		angleDegrees += 90;
+		rotate(-finalWidth / 2, -finalHeight / 2, angleDegrees, rx[0], ry[0]);
+		rotate(finalWidth / 2, -finalHeight / 2, angleDegrees, rx[1], ry[1]);
+		rotate(finalWidth / 2, finalHeight / 2, angleDegrees, rx[2], ry[2]);
+		rotate(-finalWidth / 2, finalHeight / 2, angleDegrees, rx[3], ry[3]);
+#endif  // FULL_ROTATION
+	}
 
 	void rotate(double x, double y, double degrees, double &xout, double &yout)
 	{
@@ -309,12 +539,79 @@ private:
 
 	int getSpriteID(int imageID, int frame) const
 	{
-		if (imageID >= MAX_IMAGES || frame >= MAX_FRAMES_PER_SPRITE)
+		if (imageID < 0 || imageID >= MAX_IMAGES || frame < 0 || frame >= MAX_FRAMES_PER_SPRITE)
 			return INVALID_SPRITE_ID;
 
 		return imageID * MAX_FRAMES_PER_SPRITE + frame;
 	}
 
+	static unsigned int roundUpToPowerOf2(unsigned int n)
+	{
+		unsigned int p = 1;
+		while (p < n)
+			p <<= 1;
+		return p;
+	}
+
+	  // Copy an image into the atlas and repeat its edge pixels out into its gutter
+	static void blitWithGutter(std::vector<char>& atlas, unsigned int atlasWidth, unsigned int atlasHeight,
+							   const PendingImage& image, unsigned int x, unsigned int y)
+	{
+		int pad = static_cast<int>(ATLAS_PADDING);
+		for (int ay = static_cast<int>(y) - pad; ay < static_cast<int>(y + image.height) + pad; ay++)
+		{
+			if (ay < 0 || ay >= static_cast<int>(atlasHeight))
+				continue;
+			int iy = std::min(std::max(ay - static_cast<int>(y), 0), static_cast<int>(image.height) - 1);
+			for (int ax = static_cast<int>(x) - pad; ax < static_cast<int>(x + image.width) + pad; ax++)
+			{
+				if (ax < 0 || ax >= static_cast<int>(atlasWidth))
+					continue;
+				int ix = std::min(std::max(ax - static_cast<int>(x), 0), static_cast<int>(image.width) - 1);
+				std::memcpy(&atlas[(ay * atlasWidth + ax) * 4], &image.pixels[(iy * image.width + ix) * 4], 4);
+			}
+		}
+	}
+
+	GLuint uploadTexture(unsigned int textureWidth, unsigned int textureHeight, char* imageData)
+	{
+		glEnable(GL_DEPTH_TEST);
+
+		  // allocate a texture handle
+		GLuint glTextureID;
+		glGenTextures(1, &glTextureID);
+
+		  // bind our new texture
+		glBindTexture(GL_TEXTURE_2D, glTextureID);
+
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+		if (m_mipMapped)
+		{
+			  // when texture area is small, bilinear filter the closest mipmap
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			  // when texture area is large, bilinear filter the first mipmap
+			glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		}
+		else
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		}
+
+		  // Frames sit side by side in the atlas, so never wrap around into a neighbour
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLfloat>(GL_CLAMP_TO_EDGE));
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLfloat>(GL_CLAMP_TO_EDGE));
+
+		if (m_mipMapped)
+			makeMipmaps(4, textureWidth, textureHeight, imageData);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, 4, textureWidth, textureHeight, 0, GL_BGRA, GL_UNSIGNED_BYTE, imageData);
+
+		m_boundTexture = 0;  // whatever flush last bound isn't bound any more
+		return glTextureID;
+	}
+
 	static void makeMipmaps(unsigned char byteCount, unsigned int textureWidth, unsigned int textureHeight, char* imageData)
 	{
 		int format = (byteCount == 3 ? GL_BGR : GL_BGRA);
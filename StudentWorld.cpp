@@ -2,11 +2,21 @@
 #include "GameConstants.h"
 #include "Level.h" 
 #include "Actor.h"
+#include "Snapshot.h"
 #include <iostream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 using namespace std;
 
+// Uncomment to check every cell flag lookup against a full scan of actors
+//#define VERIFY_CELL_FLAGS
+
+#ifdef VERIFY_CELL_FLAGS
+#include <cassert>
+#include <cstdlib>
+#endif
+
 GameWorld* createStudentWorld(string assetPath)
 {
 	return new StudentWorld(assetPath);
@@ -15,17 +25,75 @@ GameWorld* createStudentWorld(string assetPath)
 // Students:  Add code to this file, StudentWorld.h, Actor.h, and Actor.cpp
 
 StudentWorld::StudentWorld(string assetPath)
-: GameWorld(assetPath), m_player(nullptr), m_bonus(1000), m_crystals(0)
+: GameWorld(assetPath), m_player(nullptr), m_bonus(1000), m_crystals(0), m_exit(nullptr), m_exitRevealed(false), m_playerReachedExit(false), m_nextSpawnOrder(0), m_referencePaths(0)
 {
+    clearCellIndex();
 }
 
 StudentWorld::~StudentWorld() {
     cleanUp();
 }
 
+// Allocates an actor for the current level; destroyActor frees it
+template<typename T, typename... Args>
+T* StudentWorld::createActor(Args... args) {
+    if (m_referencePaths & HEAP_ACTORS)
+        return new T(args...);
+    return m_arena.create<T>(args...);
+}
+
+// Ticks an actor with a direct call to its class's doSomething, picked by its type tag,
+// instead of a virtual call (unless the VIRTUAL_TICKS reference path is in use)
+static void tickActor(Actor* actor, int referencePaths) {
+    if (referencePaths & StudentWorld::VIRTUAL_TICKS) {
+        actor->doSomething();
+        return;
+    }
+    switch (actor->getType()) {
+    case IID_RAGEBOT:
+        static_cast<RageBot*>(actor)->RageBot::doSomething();
+        break;
+    case IID_THIEFBOT:
+        static_cast<RegularThiefBot*>(actor)->RegularThiefBot::doSomething();
+        break;
+    case IID_MEAN_THIEFBOT:
+        static_cast<MeanThiefBot*>(actor)->MeanThiefBot::doSomething();
+        break;
+    case IID_ROBOT_FACTORY:
+        static_cast<ThiefBotFactory*>(actor)->ThiefBotFactory::doSomething();
+        break;
+    case IID_PEA:
+        static_cast<Pea*>(actor)->Pea::doSomething();
+        break;
+    case IID_EXIT:
+        static_cast<Exit*>(actor)->Exit::doSomething();
+        break;
+    case IID_PIT:
+        static_cast<Pit*>(actor)->Pit::doSomething();
+        break;
+    case IID_CRYSTAL:
+        static_cast<Crystal*>(actor)->Crystal::doSomething();
+        break;
+    case IID_RESTORE_HEALTH:
+    case IID_EXTRA_LIFE:
+    case IID_AMMO:
+        static_cast<Goodie*>(actor)->Goodie::doSomething();
+        break;
+    case IID_WALL:
+    case IID_MARBLE:
+        break; // nothing to do
+    default:
+        actor->doSomething();
+        break;
+    }
+}
+
 int StudentWorld::init()
 {
     m_bonus = 1000;
+    m_exit = nullptr;
+    m_exitRevealed = false;
+    m_playerReachedExit = false;
     switch (loadLevel()) {
         case -1:
             return GWSTATUS_LEVEL_ERROR;
@@ -42,12 +110,27 @@ int StudentWorld::move()
 {   
     setDisplayText();
 
+    if (m_crystals <= 0) { // levels without crystals open their exit on the first tick
+        revealExit();
+    }
+
+    // Tick order: the player, then the static actors it (or a marble it pushed) moved onto,
+    // then every active actor in spawn order, including ones spawned during this tick.
+    // Static actors only react to something arriving on their square, so ticking them
+    // right after the player gives the same results as ticking everything in spawn order.
+    // Only the player's moves and the marbles it pushes wake them (see updateActorLocation),
+    // so none are woken by the active actors; a new waker there would need another tickWokenActors.
     if (m_player != nullptr) { // is it ok to have this after all actors doSomething?
-        m_player->doSomething();
+        if (m_referencePaths & VIRTUAL_TICKS)
+            m_player->doSomething();
+        else
+            m_player->Player::doSomething();
     }
 
-    for (size_t k = 0; k < actors.size(); k++) {
-        actors[k]->doSomething();
+    tickWokenActors();
+
+    for (size_t k = 0; k < m_activeActors.size(); k++) {
+        tickActor(m_activeActors[k], m_referencePaths);
     }
 
     if (!isPlayerAlive()) {
@@ -56,16 +139,8 @@ int StudentWorld::move()
         return GWSTATUS_PLAYER_DIED;
     }
 
-    if (collectedCrystals()) { // if 0 crystals are left, check if the player is on the coordinates of the exit
-        int x = m_player->getX();
-        int y = m_player->getY();
-        for (vector<Actor*>::iterator p = actors.begin(); p != actors.end(); p++) {
-            if ((*p)->isInvisibleAtFirst()) {
-                if ((*p)->getX() == x && (*p)->getY() == y) {
-                    return GWSTATUS_FINISHED_LEVEL;
-                }
-            }
-        }
+    if (m_playerReachedExit) {
+        return GWSTATUS_FINISHED_LEVEL;
     }
 
     removeDeadGameObjects();
@@ -77,14 +152,24 @@ int StudentWorld::move()
 
 void StudentWorld::cleanUp()
 {   
-    std::vector<Actor*>::iterator p = actors.begin();
-    while (p != actors.end()) {
-        delete* p;
-        p = actors.erase(p);
+    // run every destructor (so teardown is still O(actors)), then hand the level's memory back to the arena in one go
+    for (size_t k = 0; k < actors.size(); k++) {
+        destroyActor(actors[k]);
     }
+    actors.clear();
+    m_activeActors.clear();
+    m_wokenActors.clear();
+    m_dying.clear();
+
+    clearCellIndex();
+    m_nextSpawnOrder = 0;
 
-    delete m_player;
-    m_player = nullptr;
+    if (m_player != nullptr) {
+        destroyActor(m_player);
+        m_player = nullptr;
+    }
+    m_exit = nullptr;
+    m_arena.reset();
 }
 
 int StudentWorld::loadLevel() {
@@ -107,44 +192,45 @@ int StudentWorld::loadLevel() {
             Level::MazeEntry item = lev.getContentsOf(x, y);
             switch (item) {
             case Level::player:
-                m_player = new Player(this, x, y);
+                m_player = createActor<Player>(this, x, y);
                 break;
             case Level::exit:
-                actors.push_back(new Exit(this, x, y));
+                m_exit = createActor<Exit>(this, x, y);
+                addActor(m_exit);
                 break;
             case Level::crystal:
-                actors.push_back(new Crystal(this, x, y));
+                addActor(createActor<Crystal>(this, x, y));
                 m_crystals++;
                 break;
             case Level::horiz_ragebot:
-                actors.push_back(new RageBot(this, x, y, GraphObject::right));
+                addActor(createActor<RageBot>(this, x, y, GraphObject::right));
                 break;
             case Level::vert_ragebot:
-                actors.push_back(new RageBot(this, x, y, GraphObject::down));
+                addActor(createActor<RageBot>(this, x, y, GraphObject::down));
                 break;
             case Level::thiefbot_factory:
-                actors.push_back(new ThiefBotFactory(this, x, y, ThiefBotFactory::REGULAR));
+                addActor(createActor<ThiefBotFactory>(this, x, y, ThiefBotFactory::REGULAR));
                 break;
             case Level::mean_thiefbot_factory:
-                actors.push_back(new ThiefBotFactory(this, x, y, ThiefBotFactory::MEAN));
+                addActor(createActor<ThiefBotFactory>(this, x, y, ThiefBotFactory::MEAN));
                 break;
             case Level::wall:
-                actors.push_back(new Wall(this, x, y));
+                addActor(createActor<Wall>(this, x, y));
                 break;
             case Level::marble:
-                actors.push_back(new Marble(this, x, y));
+                addActor(createActor<Marble>(this, x, y));
                 break;
             case Level::pit:
-                actors.push_back(new Pit(this, x, y));
+                addActor(createActor<Pit>(this, x, y));
                 break;
             case Level::extra_life:
-                actors.push_back(new ExtraLifeGoodie(this, x, y));
+                addActor(createActor<ExtraLifeGoodie>(this, x, y));
                 break;
             case Level::restore_health:
-                actors.push_back(new RestoreHealthGoodie(this, x, y));
+                addActor(createActor<RestoreHealthGoodie>(this, x, y));
                 break;
             case Level::ammo:
-                actors.push_back(new AmmoGoodie(this, x, y));
+                addActor(createActor<AmmoGoodie>(this, x, y));
                 break;
             default:
                 // Empty should be here
@@ -185,86 +271,55 @@ bool StudentWorld::isPlayerAlive() const {
 }
 
 bool StudentWorld::canMarbleMoveTo(int x, int y) const {
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        if ((*p)->getX() == x && (*p)->getY() == y) {
-            if ((*p)->allowsMarble() == false) {
-                if ((*p)->isStealable() && (*p)->isVisible() == false)
-                    continue;
-                return false;
-            }
-        }
-    }
-    return true;
+    return (getCellFlags(x, y) & BLOCKS_MARBLE) == 0;
 }
 
 bool StudentWorld::isActorAt(int x, int y) const {
     if (m_player->getX() == x && m_player->getY() == y)
         return true;
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        if ((*p)->getX() == x && (*p)->getY() == y) {
-            if ((*p)->allowsAgentColocation() == false) {
-                return true;
-            }
-        }
-    }
-    return false;
+    return (getCellFlags(x, y) & BLOCKS_AGENT) != 0;
 }
 
 bool StudentWorld::isObstacleAt(int x, int y) const {
     if (m_player->getX() == x && m_player->getY() == y)
         return true;
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        if ((*p)->getX() == x && (*p)->getY() == y) {
-            if ((*p)->allowsAgentColocation() == false && (*p)->allowsMarble() == false) { // obstacles that are non-pits
-                return true;
-            }
-        }
-    }
-    return false;
+    return (getCellFlags(x, y) & OBSTACLE) != 0; // obstacles that are non-pits
 }
 
 bool StudentWorld::isThiefBotAt(int x, int y) const {
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        Actor* actor = *p;
-        if (actor->getX() == x && actor->getY() == y) {
-            if (actor->countsInFactoryCensus()) {
-                return true;
-            }
-        }
-    }
-    return false;
+    return (getCellFlags(x, y) & FACTORY_CENSUS) != 0;
 }
 
 Actor* StudentWorld::getActorAt(int x, int y) const {
     if (m_player->getX() == x && m_player->getY() == y)
         return m_player;
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        if ((*p)->getX() == x && (*p)->getY() == y) {
-            if ((*p)->allowsAgentColocation() == false) {
-                return (*p);
-            }
+    if ((getCellFlags(x, y) & BLOCKS_AGENT) == 0)
+        return nullptr;
+    for (Actor* p = getOccupantsOf(x, y); p != nullptr; p = p->m_nextInCell) {
+        if (p->m_cellFlags & BLOCKS_AGENT) {
+            return p;
         }
     }
     return nullptr;
 }
 
 Actor* StudentWorld::getMarbleAt(int x, int y) const {
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        if ((*p)->getX() == x && (*p)->getY() == y) {
-            if ((*p)->isSwallowable()) {
-                return (*p);
-            }
+    if ((getCellFlags(x, y) & SWALLOWABLE) == 0)
+        return nullptr;
+    for (Actor* p = getOccupantsOf(x, y); p != nullptr; p = p->m_nextInCell) {
+        if (p->m_cellFlags & SWALLOWABLE) {
+            return p;
         }
     }
     return nullptr;
 }
 
 Actor* StudentWorld::getGoodieAt(int x, int y) const {
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        if ((*p)->getX() == x && (*p)->getY() == y) {
-            if ((*p)->isStealable()) {
-                return (*p);
-            }
+    if ((getCellFlags(x, y) & STEALABLE) == 0)
+        return nullptr;
+    for (Actor* p = getOccupantsOf(x, y); p != nullptr; p = p->m_nextInCell) {
+        if (p->m_cellFlags & STEALABLE) {
+            return p;
         }
     }
     return nullptr;
@@ -273,31 +328,29 @@ Actor* StudentWorld::getGoodieAt(int x, int y) const {
 Actor* StudentWorld::getDestroyableActorAt(int x, int y) const {
     if (m_player->getX() == x && m_player->getY() == y)
         return m_player;
-    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
-        Actor* actor = *p;
-        if (actor->getX() == x && actor->getY() == y) {
-            if (actor->isDestroyable()) {
-                return actor;
-            }
+    if ((getCellFlags(x, y) & DESTROYABLE) == 0)
+        return nullptr;
+    for (Actor* p = getOccupantsOf(x, y); p != nullptr; p = p->m_nextInCell) {
+        if (p->m_cellFlags & DESTROYABLE) {
+            return p;
         }
     }
     return nullptr;
 }
 
 int StudentWorld::countThiefBotsSurroundingFactory(int x, int y) const {
+    if (x < 0 || x >= VIEW_WIDTH || y < 0 || y >= VIEW_HEIGHT)
+        return 0;
+#ifdef VERIFY_CELL_FLAGS
     int count = 0;
-    int minX = x - 3;
-    int maxX = x + 3;
-    int minY = y - 3;
-    int maxY = y + 3;
-
     for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
         Actor* actor = *p;
-        if (actor->countsInFactoryCensus() && actor->getX() >= minX && actor->getX() <= maxX && actor->getY() >= minY && actor->getY() <= maxY) {
+        if (actor->countsInFactoryCensus() && abs(actor->getX() - x) <= 3 && abs(actor->getY() - y) <= 3)
             count++;
-        }
     }
-    return count;
+    assert(m_thiefBotsNear[y][x] == count);
+#endif
+    return m_thiefBotsNear[y][x];
 }
 
 void StudentWorld::setDisplayText() {
@@ -310,16 +363,72 @@ void StudentWorld::setDisplayText() {
     setGameStatText(display);
 }
 
-void  StudentWorld::removeDeadGameObjects() {
-    for (vector<Actor*>::iterator p = actors.begin(); p != actors.end();) {
-        if ((*p)->isAlive() == false) {
-            delete *p;
-            p = actors.erase(p);
+static bool spawnedBefore(const Actor* actor, int spawnOrder) {
+    return actor->getSpawnOrder() < spawnOrder;
+}
+
+// Drops dead actors from a list kept in spawn order, keeping the order of the rest.
+// Nothing spawned before the oldest dead actor has to move.
+static void eraseDeadActors(vector<Actor*>& list, int oldestDead) {
+    vector<Actor*>::iterator out = lower_bound(list.begin(), list.end(), oldestDead, spawnedBefore);
+    for (vector<Actor*>::iterator p = out; p != list.end(); p++) {
+        if ((*p)->isAlive()) {
+            *out++ = *p;
         }
-        else {
+    }
+    list.erase(out, list.end());
+}
+
+// Costs O(dead + actors spawned after the oldest dead one): peas are spawned last and die young,
+// so on a pea-heavy tick that's little more than the peas
+void StudentWorld::removeDeadGameObjects() {
+    if (m_dying.empty()) {
+        return;
+    }
+    if (m_referencePaths & ERASE_DEAD_ONE_AT_A_TIME) {
+        eraseDeadOneAtATime();
+        return;
+    }
+
+    int oldest = m_dying[0]->getSpawnOrder();
+    for (size_t k = 1; k < m_dying.size(); k++) {
+        oldest = min(oldest, m_dying[k]->getSpawnOrder());
+    }
+
+    eraseDeadActors(actors, oldest);
+    eraseDeadActors(m_activeActors, oldest);
+
+    for (size_t k = 0; k < m_dying.size(); k++) {
+        unlinkFromCell(m_dying[k], m_dying[k]->getX(), m_dying[k]->getY());
+        destroyActor(m_dying[k]);
+    }
+    m_dying.clear();
+}
+
+// The ERASE_DEAD_ONE_AT_A_TIME reference: shifts the rest of each list down once per dead actor
+void StudentWorld::eraseDeadOneAtATime() {
+    for (vector<Actor*>::iterator p = actors.begin(); p != actors.end(); ) {
+        Actor* actor = *p;
+        if (actor->isAlive()) {
             p++;
+            continue;
         }
+        p = actors.erase(p);
+        vector<Actor*>::iterator active = find(m_activeActors.begin(), m_activeActors.end(), actor);
+        if (active != m_activeActors.end())
+            m_activeActors.erase(active);
+        unlinkFromCell(actor, actor->getX(), actor->getY());
+        destroyActor(actor);
     }
+    m_dying.clear();
+}
+
+void StudentWorld::useReferencePaths(int paths) {
+    m_referencePaths = paths;
+}
+
+bool StudentWorld::usesReferencePath(int path) const {
+    return (m_referencePaths & path) != 0;
 }
 
 void StudentWorld::reduceLevelBonusByOne() {
@@ -329,33 +438,528 @@ void StudentWorld::reduceLevelBonusByOne() {
 
 void StudentWorld::reduceCrystalsByOne() {
     m_crystals--;
-}
-
-bool StudentWorld::collectedCrystals() {
     if (m_crystals <= 0) {
-        for (vector<Actor*>::iterator p = actors.begin(); p != actors.end(); p++) {
-            if ((*p)->isInvisibleAtFirst()) {
-                if ((*p)->isVisible() == false) {
-                    playSound(SOUND_REVEAL_EXIT);
-                }
-                (*p)->setVisible(true);
-                return true;
-            }
-        }
+        revealExit();
     }
-    return false;
+}
+
+bool StudentWorld::collectedCrystals() const {
+    return m_exitRevealed;
+}
+
+bool StudentWorld::playerReachedExit() const {
+    return m_playerReachedExit;
+}
+
+void StudentWorld::revealExit() {
+    if (m_exitRevealed || m_exit == nullptr)
+        return;
+    m_exitRevealed = true;
+    m_exit->setVisible(true);
+    playSound(SOUND_REVEAL_EXIT);
 }
 
 void StudentWorld::createNewPea(int x, int y, int direction) {
-    actors.push_back(new Pea(this, x, y, direction));
+    addActor(m_peaPool.create(this, x, y, direction));
 }
 
 void StudentWorld::createNewThiefBot(int x, int y, int type) {
     // Create a new ThiefBot based on the type
     if (type == 1) {
-        actors.push_back(new RegularThiefBot(this, x, y));
+        addActor(createActor<RegularThiefBot>(this, x, y));
     }
     else if (type == 2) {
-        actors.push_back(new MeanThiefBot(this, x, y));
+        addActor(createActor<MeanThiefBot>(this, x, y));
+    }
+}
+
+// The CellFlag bits an actor contributes to the cell it occupies
+static int cellFlagsOf(const Actor* actor) {
+    int flags = 0;
+    if (actor->allowsAgentColocation() == false) {
+        flags |= StudentWorld::BLOCKS_AGENT;
+        if (actor->allowsMarble() == false)
+            flags |= StudentWorld::OBSTACLE;
+    }
+    // a stolen goodie is invisible and doesn't stop marbles
+    if (actor->allowsMarble() == false && !(actor->isStealable() && actor->isVisible() == false))
+        flags |= StudentWorld::BLOCKS_MARBLE;
+    if (actor->isDestroyable())
+        flags |= StudentWorld::DESTROYABLE;
+    if (actor->isSwallowable())
+        flags |= StudentWorld::SWALLOWABLE;
+    if (actor->isStealable())
+        flags |= StudentWorld::STEALABLE;
+    if (actor->countsInFactoryCensus())
+        flags |= StudentWorld::FACTORY_CENSUS;
+    return flags;
+}
+
+void StudentWorld::addActor(Actor* actor) {
+    actor->m_spawnOrder = m_nextSpawnOrder++;
+    actor->m_cellFlags = cellFlagsOf(actor);
+    actor->m_static = actor->isStatic();
+    actors.push_back(actor);
+    if (!actor->m_static)
+        m_activeActors.push_back(actor);
+    linkToCell(actor);
+}
+
+// Frees an actor the way it was allocated: peas go back to the pea pool, everything else to the level arena
+void StudentWorld::destroyActor(Actor* actor) {
+    if (actor->getType() == IID_PEA)
+        m_peaPool.destroy(static_cast<Pea*>(actor));
+    else if (m_referencePaths & HEAP_ACTORS)
+        delete actor;
+    else
+        m_arena.destroy(actor);
+}
+
+void StudentWorld::updateActorLocation(Actor* actor, int oldX, int oldY) {
+    if (actor == m_player) { // the player is tracked separately from the cell index
+        if (m_exitRevealed && m_player->getX() == m_exit->getX() && m_player->getY() == m_exit->getY())
+            m_playerReachedExit = true;
+        wakeStaticActorsAt(m_player->getX(), m_player->getY());
+        return;
+    }
+    if (actor->getX() == oldX && actor->getY() == oldY)
+        return;
+    unlinkFromCell(actor, oldX, oldY);
+    linkToCell(actor);
+    if (actor->m_cellFlags & SWALLOWABLE) // a marble rolling onto a pit
+        wakeStaticActorsAt(actor->getX(), actor->getY());
+}
+
+void StudentWorld::wakeStaticActorsAt(int x, int y) {
+    for (Actor* p = getOccupantsOf(x, y); p != nullptr; p = p->m_nextInCell) {
+        if (p->m_static && !p->m_woken) {
+            p->m_woken = true;
+            m_wokenActors.push_back(p);
+        }
+    }
+}
+
+void StudentWorld::tickWokenActors() {
+    for (size_t k = 0; k < m_wokenActors.size(); k++) {
+        m_wokenActors[k]->m_woken = false;
+        tickActor(m_wokenActors[k], m_referencePaths);
+    }
+    m_wokenActors.clear();
+}
+
+void StudentWorld::actorDied(Actor* actor) {
+    if (actor != m_player)
+        m_dying.push_back(actor);
+}
+
+void StudentWorld::updateCellFlags(Actor* actor) {
+    if (actor == m_player)
+        return;
+    actor->m_cellFlags = cellFlagsOf(actor);
+    recomputeCellFlags(actor->getX(), actor->getY());
+}
+
+int StudentWorld::getCellFlags(int x, int y) const {
+    if (x < 0 || x >= VIEW_WIDTH || y < 0 || y >= VIEW_HEIGHT)
+        return 0;
+#ifdef VERIFY_CELL_FLAGS
+    assert(m_cellFlags[y][x] == scanCellFlags(x, y));
+#endif
+    return m_cellFlags[y][x];
+}
+
+static int lowestSetBit(unsigned int bits) {
+    int n = 0;
+    while ((bits & 1) == 0) {
+        bits >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static int highestSetBit(unsigned int bits) {
+    int n = 0;
+    while (bits >>= 1)
+        n++;
+    return n;
+}
+
+int StudentWorld::distanceToObstacle(int x, int y, int dir) const {
+    if (x < 0 || x >= VIEW_WIDTH || y < 0 || y >= VIEW_HEIGHT)
+        return -1;
+
+#ifdef VERIFY_CELL_FLAGS
+    int dx = (dir == GraphObject::right) - (dir == GraphObject::left);
+    int dy = (dir == GraphObject::up) - (dir == GraphObject::down);
+    int expected = -1;
+    for (int d = 1, cx = x + dx, cy = y + dy; (dx != 0 || dy != 0) && cx >= 0 && cx < VIEW_WIDTH && cy >= 0 && cy < VIEW_HEIGHT; d++, cx += dx, cy += dy) {
+        if (scanCellFlags(cx, cy) & OBSTACLE) {
+            expected = d;
+            break;
+        }
+    }
+#endif
+
+    unsigned int ahead = 0;
+    int distance = -1;
+    switch (dir) {
+    case GraphObject::up:
+        ahead = m_obstacleCols[x] >> (y + 1);
+        if (ahead != 0)
+            distance = lowestSetBit(ahead) + 1;
+        break;
+    case GraphObject::down:
+        ahead = m_obstacleCols[x] & ((1u << y) - 1);
+        if (ahead != 0)
+            distance = y - highestSetBit(ahead);
+        break;
+    case GraphObject::right:
+        ahead = m_obstacleRows[y] >> (x + 1);
+        if (ahead != 0)
+            distance = lowestSetBit(ahead) + 1;
+        break;
+    case GraphObject::left:
+        ahead = m_obstacleRows[y] & ((1u << x) - 1);
+        if (ahead != 0)
+            distance = x - highestSetBit(ahead);
+        break;
+    }
+
+#ifdef VERIFY_CELL_FLAGS
+    assert(distance == expected);
+#endif
+    return distance;
+}
+
+void StudentWorld::clearCellIndex() {
+    for (int y = 0; y < VIEW_HEIGHT; y++)
+        for (int x = 0; x < VIEW_WIDTH; x++) {
+            m_cells[y][x] = nullptr;
+            m_cellFlags[y][x] = 0;
+            m_thiefBotsNear[y][x] = 0;
+        }
+    for (int y = 0; y < VIEW_HEIGHT; y++)
+        m_obstacleRows[y] = 0;
+    for (int x = 0; x < VIEW_WIDTH; x++)
+        m_obstacleCols[x] = 0;
+}
+
+Actor* StudentWorld::getOccupantsOf(int x, int y) const {
+    if (x < 0 || x >= VIEW_WIDTH || y < 0 || y >= VIEW_HEIGHT)
+        return nullptr;
+    return m_cells[y][x];
+}
+
+void StudentWorld::linkToCell(Actor* actor) {
+    int x = actor->getX();
+    int y = actor->getY();
+    if (x < 0 || x >= VIEW_WIDTH || y < 0 || y >= VIEW_HEIGHT)
+        return;
+
+    // keep each cell in spawn order so lookups find the same actor a scan of actors would
+    Actor** link = &m_cells[y][x];
+    while (*link != nullptr && (*link)->m_spawnOrder < actor->m_spawnOrder)
+        link = &(*link)->m_nextInCell;
+    actor->m_nextInCell = *link;
+    *link = actor;
+    setCellFlags(x, y, m_cellFlags[y][x] | actor->m_cellFlags);
+    if (actor->m_cellFlags & FACTORY_CENSUS)
+        updateFactoryCensus(x, y, 1);
+}
+
+void StudentWorld::unlinkFromCell(Actor* actor, int x, int y) {
+    if (x < 0 || x >= VIEW_WIDTH || y < 0 || y >= VIEW_HEIGHT)
+        return;
+
+    for (Actor** link = &m_cells[y][x]; *link != nullptr; link = &(*link)->m_nextInCell) {
+        if (*link == actor) {
+            *link = actor->m_nextInCell;
+            actor->m_nextInCell = nullptr;
+            recomputeCellFlags(x, y);
+            if (actor->m_cellFlags & FACTORY_CENSUS)
+                updateFactoryCensus(x, y, -1);
+            return;
+        }
+    }
+}
+
+void StudentWorld::recomputeCellFlags(int x, int y) {
+    if (x < 0 || x >= VIEW_WIDTH || y < 0 || y >= VIEW_HEIGHT)
+        return;
+
+    int flags = 0;
+    for (Actor* p = m_cells[y][x]; p != nullptr; p = p->m_nextInCell)
+        flags |= p->m_cellFlags;
+    setCellFlags(x, y, flags);
+}
+
+void StudentWorld::setCellFlags(int x, int y, int flags) {
+    m_cellFlags[y][x] = flags;
+
+    // keep the row and column obstacle masks used for line of sight in step
+    if (flags & OBSTACLE) {
+        m_obstacleRows[y] |= 1u << x;
+        m_obstacleCols[x] |= 1u << y;
+    }
+    else {
+        m_obstacleRows[y] &= ~(1u << x);
+        m_obstacleCols[x] &= ~(1u << y);
+    }
+}
+
+// A ThiefBot arriving at or leaving (x, y) changes the census of every factory within 3 squares
+void StudentWorld::updateFactoryCensus(int x, int y, int delta) {
+    int minX = max(x - 3, 0);
+    int maxX = min(x + 3, VIEW_WIDTH - 1);
+    int minY = max(y - 3, 0);
+    int maxY = min(y + 3, VIEW_HEIGHT - 1);
+
+    for (int cy = minY; cy <= maxY; cy++)
+        for (int cx = minX; cx <= maxX; cx++)
+            m_thiefBotsNear[cy][cx] += delta;
+}
+
+// Slow path for VERIFY_CELL_FLAGS: the flags of a cell worked out from a scan of every actor
+int StudentWorld::scanCellFlags(int x, int y) const {
+    int flags = 0;
+    for (vector<Actor*>::const_iterator p = actors.begin(); p != actors.end(); p++) {
+        if ((*p)->getX() == x && (*p)->getY() == y)
+            flags |= cellFlagsOf(*p);
+    }
+    return flags;
+}
+
+// Snapshot layout (all numbers varints, signed ones zigzagged, unless noted):
+//   "MMSS", format version (byte)
+//   level, lives, score, bonus, crystals left, next spawn order
+//   flags (byte): exit revealed, player reached exit, has player
+//   random number generator state (4 little-endian 64-bit words)
+//   player, if any: x, y, alive (byte), state
+//   actor count, then per actor in spawn order:
+//     image ID << 1 | alive (byte), spawn order minus the previous actor's (the first's minus -1), x, y, state,
+//     and for a ThiefBot 1 + the index of the goodie it stole, or 0
+// Actors killed this tick but not yet removed are kept, so a restored world finishes the tick the same way.
+static const char SNAPSHOT_MAGIC[4] = { 'M', 'M', 'S', 'S' };
+static const unsigned int SNAPSHOT_VERSION = 1;
+
+static bool isThiefBotType(int type) {
+    return type == IID_THIEFBOT || type == IID_MEAN_THIEFBOT;
+}
+
+bool StudentWorld::saveSnapshot(string& out) const {
+    out.clear(); // keeps the capacity, so snapshotting every tick into one buffer doesn't allocate
+    SnapshotWriter w(out);
+    w.putBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    w.putByte(SNAPSHOT_VERSION);
+    w.putInt(getLevel());
+    w.putInt(getLives());
+    w.putInt(getScore());
+    w.putInt(m_bonus);
+    w.putInt(m_crystals);
+    w.putInt(m_nextSpawnOrder);
+    w.putByte((m_exitRevealed ? 1 : 0) | (m_playerReachedExit ? 2 : 0) | (m_player != nullptr ? 4 : 0));
+    uint64_t rng[4];
+    getRandomState(rng);
+    for (int k = 0; k < 4; k++)
+        w.putWord(rng[k]);
+
+    if (m_player != nullptr) {
+        w.putInt(m_player->getX());
+        w.putInt(m_player->getY());
+        w.putBool(m_player->isAlive());
+        m_player->saveState(w);
+    }
+
+    w.putVarint(actors.size());
+    int prevSpawnOrder = -1;
+    for (size_t k = 0; k < actors.size(); k++) {
+        const Actor* actor = actors[k];
+        w.putByte((actor->getType() << 1) | (actor->isAlive() ? 1 : 0));
+        w.putVarint(actor->getSpawnOrder() - prevSpawnOrder);
+        prevSpawnOrder = actor->getSpawnOrder();
+        w.putInt(actor->getX());
+        w.putInt(actor->getY());
+        actor->saveState(w);
+        if (isThiefBotType(actor->getType())) {
+            // actors is in spawn order, so the goodie's index is a binary search away
+            const Actor* goodie = static_cast<const ThiefBot*>(actor)->getStolenGoodie();
+            size_t link = 0;
+            if (goodie != nullptr) {
+                vector<Actor*>::const_iterator p = lower_bound(actors.begin(), actors.end(), goodie->getSpawnOrder(), spawnedBefore);
+                if (p != actors.end() && *p == goodie)
+                    link = p - actors.begin() + 1;
+            }
+            w.putVarint(link);
+        }
+    }
+    return true;
+}
+
+// Rolling back usually lands a few ticks from where the world is, with most actors unchanged, so
+// restoring reuses every actor whose spawn order and type match one in the snapshot and overwrites
+// its state; only actors that have died or been born since are destroyed or created.  The cell
+// index is then rebuilt in one pass.
+bool StudentWorld::restoreSnapshot(const string& data) {
+    SnapshotReader r(data);
+    if (!r.matchBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) || r.getByte() != SNAPSHOT_VERSION) {
+        cleanUp();
+        return false;
+    }
+    int level = r.getInt();
+    int lives = r.getInt();
+    int score = r.getInt();
+    int bonus = r.getInt();
+    int crystals = r.getInt();
+    int nextSpawnOrder = r.getInt();
+    unsigned int flags = r.getByte();
+    uint64_t rng[4];
+    for (int k = 0; k < 4; k++)
+        rng[k] = r.getWord();
+    if (r.failed() || nextSpawnOrder < 0) {
+        cleanUp();
+        return false;
+    }
+
+    m_wokenActors.clear(); // empty between ticks anyway
+    m_dying.clear();
+    m_exit = nullptr;
+
+    if (flags & 4) {
+        int x = r.getInt();
+        int y = r.getInt();
+        bool alive = r.getBool();
+        if (m_player == nullptr)
+            m_player = createActor<Player>(this, x, y);
+        else if (m_player->getX() != x || m_player->getY() != y)
+            m_player->GraphObject::moveTo(x, y); // not Actor::moveTo: that would tell the world the player stepped there
+        m_player->restoreState(r);
+        m_player->m_alive = alive;
     }
-}
\ No newline at end of file
+    else if (m_player != nullptr) {
+        destroyActor(m_player);
+        m_player = nullptr;
+    }
+
+    // every actor takes several bytes, so a count larger than the snapshot means it's corrupt
+    uint64_t count = r.getVarint();
+    bool ok = !r.failed() && count <= data.size();
+    vector<Actor*>& restored = m_restoredActors;
+    restored.clear();
+    if (ok)
+        restored.reserve(count);
+    size_t old = 0; // next actor of the current world to match against
+    int spawnOrder = -1;
+    for (uint64_t k = 0; k < count && ok; k++) {
+        unsigned int typeAndAlive = r.getByte();
+        int type = typeAndAlive >> 1;
+        uint64_t delta = r.getVarint();
+        int x = r.getInt();
+        int y = r.getInt();
+        if (r.failed() || delta == 0 || delta >= static_cast<uint64_t>(nextSpawnOrder - spawnOrder)) {
+            ok = false;
+            break;
+        }
+        spawnOrder += static_cast<int>(delta);
+
+        while (old < actors.size() && actors[old]->m_spawnOrder < spawnOrder)
+            destroyActor(actors[old++]);
+        Actor* actor = nullptr;
+        if (old < actors.size() && actors[old]->m_spawnOrder == spawnOrder && actors[old]->getType() == type) {
+            actor = actors[old++];
+            if (actor->getX() != x || actor->getY() != y)
+                actor->GraphObject::moveTo(x, y);
+        }
+        else {
+            actor = createActorOfType(type, x, y);
+            if (actor == nullptr) {
+                ok = false;
+                break;
+            }
+            actor->m_spawnOrder = spawnOrder;
+            actor->m_static = actor->isStatic();
+        }
+        restored.push_back(actor);
+        actor->restoreState(r);
+        actor->m_alive = (typeAndAlive & 1) != 0;
+        actor->m_woken = false;
+        if (!actor->m_alive)
+            m_dying.push_back(actor);
+        if (type == IID_EXIT)
+            m_exit = static_cast<Exit*>(actor);
+        if (isThiefBotType(type)) {
+            // goodies only come from the level file and ThiefBots only from factories, so the goodie was restored already
+            uint64_t link = r.getVarint();
+            if (link > k) {
+                ok = false;
+                break;
+            }
+            static_cast<ThiefBot*>(actor)->setStolenGoodie(link == 0 ? nullptr : restored[link - 1]);
+        }
+    }
+    ok = ok && !r.failed() && r.atEnd();
+
+    while (old < actors.size())
+        destroyActor(actors[old++]);
+    actors.swap(restored);
+    restored.clear();
+    if (!ok) {
+        cleanUp();
+        return false;
+    }
+
+    m_activeActors.clear();
+    clearCellIndex();
+    for (size_t k = 0; k < actors.size(); k++) {
+        Actor* actor = actors[k];
+        if (!actor->m_static)
+            m_activeActors.push_back(actor);
+        actor->m_cellFlags = cellFlagsOf(actor);
+        actor->m_nextInCell = nullptr;
+        linkToCell(actor);
+    }
+
+    setLevel(level);
+    setLives(lives);
+    setScore(score);
+    m_bonus = bonus;
+    m_crystals = crystals;
+    m_nextSpawnOrder = nextSpawnOrder;
+    m_exitRevealed = (flags & 1) != 0;
+    m_playerReachedExit = (flags & 2) != 0;
+    setRandomState(rng); // last: constructing a ThiefBot draws a random number
+    return true;
+}
+
+// An actor of the given image ID in its initial state, for restoreSnapshot to fill in
+Actor* StudentWorld::createActorOfType(int type, int x, int y) {
+    switch (type) {
+    case IID_RAGEBOT:
+        return createActor<RageBot>(this, x, y, GraphObject::right);
+    case IID_THIEFBOT:
+        return createActor<RegularThiefBot>(this, x, y);
+    case IID_MEAN_THIEFBOT:
+        return createActor<MeanThiefBot>(this, x, y);
+    case IID_ROBOT_FACTORY:
+        return createActor<ThiefBotFactory>(this, x, y, ThiefBotFactory::REGULAR);
+    case IID_PEA:
+        return m_peaPool.create(this, x, y, GraphObject::right);
+    case IID_WALL:
+        return createActor<Wall>(this, x, y);
+    case IID_EXIT:
+        return createActor<Exit>(this, x, y);
+    case IID_MARBLE:
+        return createActor<Marble>(this, x, y);
+    case IID_PIT:
+        return createActor<Pit>(this, x, y);
+    case IID_CRYSTAL:
+        return createActor<Crystal>(this, x, y);
+    case IID_RESTORE_HEALTH:
+        return createActor<RestoreHealthGoodie>(this, x, y);
+    case IID_EXTRA_LIFE:
+        return createActor<ExtraLifeGoodie>(this, x, y);
+    case IID_AMMO:
+        return createActor<AmmoGoodie>(this, x, y);
+    default:
+        return nullptr; // not an actor a snapshot can hold
+    }
+}
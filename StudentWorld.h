@@ -3,16 +3,40 @@
 
 #include "GameWorld.h"
 #include "Level.h"
+#include "ObjectPool.h"
+#include "LevelArena.h"
 #include <string>
 #include <vector>
 
 class Actor;
 class Player;
+class Exit;
+class Pea;
+
 // Students:  Add code to this file, StudentWorld.cpp, Actor.h, and Actor.cpp
 
 class StudentWorld : public GameWorld
 {
 public:
+  // What the actors occupying a cell allow, OR-ed over all of them (the player is not included)
+  enum CellFlag {
+    BLOCKS_AGENT = 1 << 0, // something an agent can't share a square with
+    OBSTACLE = 1 << 1, // blocks agents and isn't a pit; stops peas and shots
+    BLOCKS_MARBLE = 1 << 2, // a marble can't be pushed here
+    DESTROYABLE = 1 << 3,
+    SWALLOWABLE = 1 << 4,
+    STEALABLE = 1 << 5,
+    FACTORY_CENSUS = 1 << 6 // a ThiefBot
+  };
+
+  // Simpler code that some of the faster paths replaced, kept so benchmarks and checks can
+  // compare the two; the results must be identical either way
+  enum ReferencePath {
+    ERASE_DEAD_ONE_AT_A_TIME = 1 << 0, // removeDeadGameObjects erases each dead actor from the lists separately
+    VIRTUAL_TICKS = 1 << 1, // actors' doSomething and agents' hooks are virtual calls instead of dispatched on the type tag
+    HEAP_ACTORS = 1 << 2 // actors other than peas are allocated with new and freed with delete, not in the level arena
+  };
+
   StudentWorld(std::string assetPath);
   ~StudentWorld();
   virtual int init();
@@ -36,17 +60,61 @@ public:
 
   void setDisplayText();
   void removeDeadGameObjects();
+  void useReferencePaths(int paths); // ReferencePath bits OR-ed together; 0 for the normal paths (set before init)
+  bool usesReferencePath(int path) const;
   void reduceLevelBonusByOne();
   void reduceCrystalsByOne();
-  bool collectedCrystals();
+  bool collectedCrystals() const;
+  bool playerReachedExit() const;
   void createNewPea(int x, int y, int direction);
   void createNewThiefBot(int x, int y, int type);
+  void addActor(Actor* actor);
+  void updateActorLocation(Actor* actor, int oldX, int oldY);
+  void actorDied(Actor* actor); // queues a killed actor for removal at the end of the tick
+  void updateCellFlags(Actor* actor); // call after anything a CellFlag depends on changes (e.g. visibility)
+  int getCellFlags(int x, int y) const;
+  // Squares from (x, y) to the first OBSTACLE cell in direction dir, or -1 if nothing is in the way
+  int distanceToObstacle(int x, int y, int dir) const;
+  virtual bool saveSnapshot(std::string& out) const;
+  virtual bool restoreSnapshot(const std::string& data); // reuses the actors it can, so it's much cheaper than loadLevel
 
 private:
+  Actor* getOccupantsOf(int x, int y) const;
+  void linkToCell(Actor* actor);
+  void unlinkFromCell(Actor* actor, int x, int y);
+  void revealExit();
+  void wakeStaticActorsAt(int x, int y);
+  void tickWokenActors();
+  template<typename T, typename... Args> T* createActor(Args... args); // in the level arena; peas use m_peaPool
+  void destroyActor(Actor* actor);
+  void recomputeCellFlags(int x, int y);
+  void setCellFlags(int x, int y, int flags);
+  void updateFactoryCensus(int x, int y, int delta);
+  int scanCellFlags(int x, int y) const;
+  Actor* createActorOfType(int type, int x, int y);
+  void eraseDeadOneAtATime();
+  void clearCellIndex();
+
 	Player* m_player; // tracks player
-	std::vector<Actor*> actors; // array of Actor pointers
+	std::vector<Actor*> actors; // array of Actor pointers, in spawn order
+	std::vector<Actor*> m_activeActors; // non-static actors, ticked every turn in spawn order
+	std::vector<Actor*> m_wokenActors; // static actors to tick once this turn
+	std::vector<Actor*> m_dying; // actors killed this tick, freed together by removeDeadGameObjects
+	ObjectPool<Pea> m_peaPool; // storage for peas, reused across shots and levels
+	LevelArena m_arena; // storage for every other actor of the current level, reused by the next
 	int m_bonus; // tracks bonus points
 	int m_crystals; // tracks # of crystals left
+	Exit* m_exit; // the level's exit
+	bool m_exitRevealed; // set once, when the last crystal is collected
+	bool m_playerReachedExit; // set when the player steps onto the revealed exit
+	Actor* m_cells[VIEW_HEIGHT][VIEW_WIDTH]; // head of each cell's occupant list, in spawn order
+	int m_cellFlags[VIEW_HEIGHT][VIEW_WIDTH]; // CellFlag bits of each cell's occupants
+	int m_thiefBotsNear[VIEW_HEIGHT][VIEW_WIDTH]; // ThiefBots within 3 squares of each cell (a factory's census)
+	unsigned int m_obstacleRows[VIEW_HEIGHT]; // bit x set if (x, y) has an OBSTACLE
+	unsigned int m_obstacleCols[VIEW_WIDTH]; // bit y set if (x, y) has an OBSTACLE
+	int m_nextSpawnOrder; // spawn order given to the next added actor
+	int m_referencePaths; // ReferencePath bits
+	std::vector<Actor*> m_restoredActors; // scratch list for restoreSnapshot, kept to reuse its storage
 };
 
 #endif // STUDENTWORLD_H_
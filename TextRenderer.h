@@ -0,0 +1,343 @@
+#ifndef TEXTRENDERER_H_
+#define TEXTRENDERER_H_
+
+#if defined(__APPLE__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+
+#include "freeglut.h"
+
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+// Draws text from a texture holding every printable character of GLUT's stroke roman
+// font, rendered once.  Each string keeps the quads for its characters, rebuilt only
+// when the string changes, so drawing one is a single draw call.  Sizes and positions
+// are in stroke font units, as for glutStrokeCharacter.
+
+class TextRenderer
+{
+public:
+
+	  // A string and the quads that draw it
+	class Text
+	{
+	public:
+		Text()
+		 : m_width(0), m_built(false)
+		{
+		}
+
+		void set(const std::string& str)
+		{
+			if (str != m_str)
+			{
+				m_str = str;
+				m_built = false;
+			}
+		}
+
+		const std::string& get() const
+		{
+			return m_str;
+		}
+
+	private:
+		friend class TextRenderer;
+
+		std::string				m_str;
+		std::vector<GLfloat>	m_vertices;
+		std::vector<GLfloat>	m_texCoords;
+		double					m_width;
+		bool					m_built;
+	};
+
+	TextRenderer()
+	 : m_texture(0), m_cellHeight(0)
+	{
+	}
+
+	~TextRenderer()
+	{
+		if (m_texture != 0)
+			glDeleteTextures(1, &m_texture);
+	}
+
+	bool isBuilt() const
+	{
+		return m_texture != 0;
+	}
+
+	  // Trace each glyph's strokes in feedback mode, which hands back the line segments
+	  // GL would have drawn instead of drawing them, and rasterize those into the glyph
+	  // texture here.  Nothing is drawn in the window, whose pixels are undefined when read
+	  // back if it's covered or off screen, so this only needs a current GL context.
+	void buildGlyphAtlas()
+	{
+		int cellHeight = toPixels(ASCENT + DESCENT + 2 * PADDING);
+		m_cellHeight = cellHeight;
+
+		  // lay the glyphs out in shelves of equal height
+		int x = 0, y = 0;
+		for (int c = FIRST_CHAR; c <= LAST_CHAR; c++)
+		{
+			Glyph& g = m_glyphs[c - FIRST_CHAR];
+			g.advance = glutStrokeWidthf(GLUT_STROKE_ROMAN, c);
+			g.pixelWidth = toPixels(g.advance + 2 * PADDING);
+			if (x + g.pixelWidth > ATLAS_WIDTH)
+			{
+				x = 0;
+				y += cellHeight;
+			}
+			g.x = x;
+			g.y = y;
+			x += g.pixelWidth;
+		}
+		int atlasHeight = 1;
+		while (atlasHeight < y + cellHeight)
+			atlasHeight <<= 1;
+
+		std::vector<unsigned char> atlas(ATLAS_WIDTH * atlasHeight, 0);
+		std::vector<GLfloat> feedback(4096);
+		std::vector<GLfloat> segments;
+
+		glPushAttrib(GL_VIEWPORT_BIT);
+		glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glMatrixMode(GL_PROJECTION);
+		glPushMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPushMatrix();
+
+		for (int c = FIRST_CHAR; c <= LAST_CHAR; c++)
+		{
+			Glyph& g = m_glyphs[c - FIRST_CHAR];
+			double unitsWide = static_cast<double>(g.pixelWidth) / PIXELS_PER_UNIT;
+			double unitsHigh = static_cast<double>(cellHeight) / PIXELS_PER_UNIT;
+
+			  // window coordinates of the segments are then pixels of the glyph's cell
+			glViewport(0, 0, g.pixelWidth, cellHeight);
+			glMatrixMode(GL_PROJECTION);
+			glLoadIdentity();
+			glOrtho(-PADDING, unitsWide - PADDING, -DESCENT - PADDING, unitsHigh - DESCENT - PADDING, -1, 1);
+			glMatrixMode(GL_MODELVIEW);
+			traceStrokes(c, feedback, segments);
+			drawLines(segments, &atlas[g.y * ATLAS_WIDTH + g.x], ATLAS_WIDTH, g.pixelWidth, cellHeight);
+
+			g.u0 = static_cast<GLfloat>(g.x) / ATLAS_WIDTH;
+			g.v0 = static_cast<GLfloat>(g.y) / atlasHeight;
+			g.u1 = static_cast<GLfloat>(g.x + g.pixelWidth) / ATLAS_WIDTH;
+			g.v1 = static_cast<GLfloat>(g.y + cellHeight) / atlasHeight;
+		}
+
+		glMatrixMode(GL_PROJECTION);
+		glPopMatrix();
+		glMatrixMode(GL_MODELVIEW);
+		glPopMatrix();
+
+		glGenTextures(1, &m_texture);
+		glBindTexture(GL_TEXTURE_2D, m_texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLfloat>(GL_CLAMP_TO_EDGE));
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLfloat>(GL_CLAMP_TO_EDGE));
+#ifdef __APPLE__
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_WIDTH, atlasHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, atlas.data());
+		glGenerateMipmap(GL_TEXTURE_2D);
+#else
+		gluBuild2DMipmaps(GL_TEXTURE_2D, GL_ALPHA, ATLAS_WIDTH, atlasHeight, GL_ALPHA, GL_UNSIGNED_BYTE, atlas.data());
+#endif
+
+		glPopClientAttrib();
+		glPopAttrib();
+	}
+
+	  // Width of the text in font units, like glutStrokeLengthf
+	double width(Text& text)
+	{
+		build(text);
+		return text.m_width;
+	}
+
+	  // Draw the text in the current color, starting at (x,y,z) and scaled by scale, with
+	  // the modelview matrix reset as for the stroke font.  Call buildGlyphAtlas first.
+	void draw(Text& text, double x, double y, double z, double scale)
+	{
+		build(text);
+		if (text.m_vertices.empty())
+			return;
+
+		glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_TEXTURE_BIT);
+		glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+		glPushMatrix();
+		glLoadIdentity();
+		glTranslatef(static_cast<GLfloat>(x), static_cast<GLfloat>(y), static_cast<GLfloat>(z));
+		glScalef(static_cast<GLfloat>(scale), static_cast<GLfloat>(scale), static_cast<GLfloat>(scale));
+
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_TEXTURE_2D);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glBindTexture(GL_TEXTURE_2D, m_texture);
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glVertexPointer(2, GL_FLOAT, 0, text.m_vertices.data());
+		glTexCoordPointer(2, GL_FLOAT, 0, text.m_texCoords.data());
+		glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(text.m_vertices.size() / 2));
+
+		glPopMatrix();
+		glPopClientAttrib();
+		glPopAttrib();
+	}
+
+private:
+	  // Prevent copying or assigning TextRenderers
+	TextRenderer(const TextRenderer&);
+	TextRenderer& operator=(const TextRenderer&);
+
+	static const int FIRST_CHAR = ' ';
+	static const int LAST_CHAR = '~';
+	static const int ATLAS_WIDTH = 512;
+	static constexpr double ASCENT = 119.05;  // of GLUT_STROKE_ROMAN, in font units
+	static constexpr double DESCENT = 33.33;
+	static constexpr double PADDING = 8;  // room for strokes a little outside the glyph box
+	static constexpr double PIXELS_PER_UNIT = 0.375;  // glyphs are drawn a few times larger than the HUD shows them
+	static constexpr double LINE_WIDTH = 3;
+
+	struct Glyph
+	{
+		GLfloat	advance;  // in font units; the roman font's widths aren't whole numbers
+		int		x;
+		int		y;
+		int		pixelWidth;
+		GLfloat	u0, v0, u1, v1;
+	};
+
+	GLuint	m_texture;
+	int		m_cellHeight;  // in pixels; every glyph's cell is as high as the font
+	Glyph	m_glyphs[LAST_CHAR - FIRST_CHAR + 1];
+
+	static int toPixels(double units)
+	{
+		return static_cast<int>(std::ceil(units * PIXELS_PER_UNIT));
+	}
+
+	  // The line segments stroking character c under the current projection, in window
+	  // coordinates, as x0, y0, x1, y1 for each.  feedback is grown if it's too small.
+	static void traceStrokes(int c, std::vector<GLfloat>& feedback, std::vector<GLfloat>& segments)
+	{
+		GLint count;
+		for (;;)
+		{
+			glFeedbackBuffer(static_cast<GLsizei>(feedback.size()), GL_2D, feedback.data());
+			glRenderMode(GL_FEEDBACK);
+			glLoadIdentity();
+			glutStrokeCharacter(GLUT_STROKE_ROMAN, c);
+			count = glRenderMode(GL_RENDER);
+			if (count >= 0)
+				break;
+			feedback.resize(feedback.size() * 2);  // it overflowed
+		}
+
+		segments.clear();
+		for (GLint k = 0; k < count; )
+		{
+			GLint token = static_cast<GLint>(feedback[k++]);
+			if (token == GL_LINE_TOKEN || token == GL_LINE_RESET_TOKEN)
+			{
+				segments.insert(segments.end(), &feedback[k], &feedback[k + 4]);
+				k += 4;
+			}
+			else if (token == GL_POLYGON_TOKEN)
+				k += 1 + 2 * static_cast<GLint>(feedback[k]);
+			else if (token == GL_PASS_THROUGH_TOKEN || token == GL_POINT_TOKEN  ||
+					 token == GL_BITMAP_TOKEN || token == GL_DRAW_PIXEL_TOKEN || token == GL_COPY_PIXEL_TOKEN)
+				k += (token == GL_PASS_THROUGH_TOKEN ? 1 : 2);
+			else
+				break;  // not a token GL_2D feedback produces
+		}
+	}
+
+	  // Draw antialiased lines LINE_WIDTH pixels wide along segments into a width by height
+	  // block of 8-bit coverage values, rows pitch apart and bottom row first
+	static void drawLines(const std::vector<GLfloat>& segments, unsigned char* pixels, int pitch, int width, int height)
+	{
+		const double halfWidth = LINE_WIDTH / 2;
+		for (std::size_t k = 0; k + 3 < segments.size(); k += 4)
+		{
+			double x0 = segments[k], y0 = segments[k + 1];
+			double dx = segments[k + 2] - x0, dy = segments[k + 3] - y0;
+			double lengthSq = dx * dx + dy * dy;
+			int left = std::max(static_cast<int>(std::floor(std::min(x0, x0 + dx) - halfWidth)), 0);
+			int right = std::min(static_cast<int>(std::ceil(std::max(x0, x0 + dx) + halfWidth)), width);
+			int bottom = std::max(static_cast<int>(std::floor(std::min(y0, y0 + dy) - halfWidth)), 0);
+			int top = std::min(static_cast<int>(std::ceil(std::max(y0, y0 + dy) + halfWidth)), height);
+			for (int py = bottom; py < top; py++)
+				for (int px = left; px < right; px++)
+				{
+					  // distance from the pixel's center to the segment
+					double cx = px + 0.5 - x0, cy = py + 0.5 - y0;
+					double t = (lengthSq > 0 ? std::min(std::max((cx * dx + cy * dy) / lengthSq, 0.0), 1.0) : 0);
+					double ex = cx - t * dx, ey = cy - t * dy;
+					double coverage = halfWidth + 0.5 - std::sqrt(ex * ex + ey * ey);
+					if (coverage <= 0)
+						continue;
+					unsigned char value = static_cast<unsigned char>(std::min(coverage, 1.0) * 255 + 0.5);
+					unsigned char& pixel = pixels[py * pitch + px];
+					pixel = std::max(pixel, value);  // where strokes meet, don't count both
+				}
+		}
+	}
+
+	void build(Text& text)
+	{
+		if (text.m_built)
+			return;
+		assert(isBuilt());  // glyph metrics come from building the atlas
+
+		text.m_vertices.clear();
+		text.m_texCoords.clear();
+		double x = 0;
+		for (unsigned char c : text.m_str)
+		{
+			if (c < FIRST_CHAR || c > LAST_CHAR)
+				continue;
+			const Glyph& g = m_glyphs[c - FIRST_CHAR];
+			GLfloat left = static_cast<GLfloat>(x - PADDING);
+			GLfloat right = static_cast<GLfloat>(x - PADDING + g.pixelWidth / PIXELS_PER_UNIT);
+			GLfloat bottom = static_cast<GLfloat>(-DESCENT - PADDING);
+			GLfloat top = static_cast<GLfloat>(bottom + m_cellHeight / PIXELS_PER_UNIT);
+			const GLfloat corners[4][4] = {
+				{ left,  bottom, g.u0, g.v0 },
+				{ right, bottom, g.u1, g.v0 },
+				{ right, top,    g.u1, g.v1 },
+				{ left,  top,    g.u0, g.v1 }
+			};
+			for (int k = 0; k < 4; k++)
+			{
+				text.m_vertices.push_back(corners[k][0]);
+				text.m_vertices.push_back(corners[k][1]);
+				text.m_texCoords.push_back(corners[k][2]);
+				text.m_texCoords.push_back(corners[k][3]);
+			}
+			x += g.advance;
+		}
+		text.m_width = x;
+		text.m_built = true;
+	}
+};
+
+#if defined(__APPLE__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // TEXTRENDERER_H_
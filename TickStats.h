@@ -0,0 +1,137 @@
+#ifndef TICKSTATS_H_
+#define TICKSTATS_H_
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+// Running statistics on how late each tick started relative to its deadline, on the
+// interval between successive ticks, and on how long each tick's simulation step took.
+// Times are in microseconds.
+
+class TickStats
+{
+public:
+
+	TickStats()
+	 : m_ticks(0), m_lateTicks(0), m_resyncs(0),
+	   m_latenessSum(0), m_latenessSumSq(0), m_maxLateness(0),
+	   m_intervalSum(0), m_minInterval(0), m_maxInterval(0),
+	   m_latencyHistogram(MAX_HISTOGRAM_LATENCY + 1, 0), m_latencyCount(0),
+	   m_latencySum(0), m_maxLatency(0)
+	{
+	}
+
+	  // lateness: how long after its deadline the tick started;
+	  // interval: time since the previous tick started (ignored for the first tick)
+	void recordTick(double lateness, double interval)
+	{
+		if (lateness > LATE_THRESHOLD)
+			m_lateTicks++;
+		m_latenessSum += lateness;
+		m_latenessSumSq += lateness * lateness;
+		if (lateness > m_maxLateness)
+			m_maxLateness = lateness;
+
+		if (m_ticks > 0)
+		{
+			m_intervalSum += interval;
+			if (m_ticks == 1 || interval < m_minInterval)
+				m_minInterval = interval;
+			if (interval > m_maxInterval)
+				m_maxInterval = interval;
+		}
+		m_ticks++;
+	}
+
+	  // how long one simulation step took
+	void recordLatency(double latency)
+	{
+		  // 1us buckets give the percentiles; anything slower lands in the last one
+		int bucket = static_cast<int>(latency);
+		if (bucket < 0)
+			bucket = 0;
+		else if (bucket > MAX_HISTOGRAM_LATENCY)
+			bucket = MAX_HISTOGRAM_LATENCY;
+		m_latencyHistogram[bucket]++;
+		m_latencyCount++;
+		m_latencySum += latency;
+		if (latency > m_maxLatency)
+			m_maxLatency = latency;
+	}
+
+	  // the latency that the given fraction of steps took no longer than
+	double latencyPercentile(double fraction) const
+	{
+		long long wanted = static_cast<long long>(std::ceil(fraction * m_latencyCount));
+		long long seen = 0;
+		for (int k = 0; k <= MAX_HISTOGRAM_LATENCY; k++)
+		{
+			seen += m_latencyHistogram[k];
+			if (seen >= wanted)
+				return k < MAX_HISTOGRAM_LATENCY ? k + 1 : m_maxLatency;
+		}
+		return m_maxLatency;
+	}
+
+	  // the scheduler fell too far behind and skipped ahead instead of catching up
+	void recordResync()
+	{
+		m_resyncs++;
+	}
+
+	long long ticks() const
+	{
+		return m_ticks;
+	}
+
+	  // Simulation throughput over wallSeconds, and the distribution of step latencies
+	void reportThroughput(std::ostream& os, double wallSeconds) const
+	{
+		os << "Simulated " << m_latencyCount << " ticks in " << wallSeconds << "s";
+		if (wallSeconds > 0)
+			os << " (" << m_latencyCount / wallSeconds << " ticks/sec)";
+		os << std::endl;
+		if (m_latencyCount > 0)
+			os << "  tick latency: mean " << m_latencySum / m_latencyCount << "us, p99 "
+			   << latencyPercentile(0.99) << "us, max " << m_maxLatency << "us" << std::endl;
+	}
+
+	void report(std::ostream& os, double targetInterval) const
+	{
+		if (m_ticks == 0)
+			return;
+
+		double meanLateness = m_latenessSum / m_ticks;
+		double variance = m_latenessSumSq / m_ticks - meanLateness * meanLateness;
+		os << "Ticks: " << m_ticks << " (target interval " << targetInterval << "us)" << std::endl;
+		os << "  lateness: mean " << meanLateness << "us, stddev "
+		   << std::sqrt(variance > 0 ? variance : 0) << "us, max " << m_maxLateness << "us, "
+		   << m_lateTicks << " ticks over " << LATE_THRESHOLD << "us late" << std::endl;
+		if (m_ticks > 1)
+			os << "  interval: mean " << m_intervalSum / (m_ticks - 1) << "us, min "
+			   << m_minInterval << "us, max " << m_maxInterval << "us" << std::endl;
+		if (m_resyncs > 0)
+			os << "  fell behind and resynchronized " << m_resyncs << " times" << std::endl;
+	}
+
+private:
+	static constexpr double LATE_THRESHOLD = 1000;
+	static const int MAX_HISTOGRAM_LATENCY = 100000;
+
+	long long	m_ticks;
+	long long	m_lateTicks;
+	long long	m_resyncs;
+	double		m_latenessSum;
+	double		m_latenessSumSq;
+	double		m_maxLateness;
+	double		m_intervalSum;
+	double		m_minInterval;
+	double		m_maxInterval;
+	std::vector<long long> m_latencyHistogram;  // count of steps taking k to k+1 us
+	long long	m_latencyCount;
+	double		m_latencySum;
+	double		m_maxLatency;
+};
+
+#endif // TICKSTATS_H_
@@ -1,9 +1,16 @@
 #include "GameController.h"
+#include "HeadlessDriver.h"
+#include "Replay.h"
+#include "GraphObject.h"
+#include "Benchmarks.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <cstdlib>
 #include <ctime>
+#include <cctype>
+#include <random>
+#include <chrono>
 using namespace std;
 
   // If your program is having trouble finding the Assets directory,
@@ -33,8 +40,267 @@ class GameWorld;
 
 GameWorld* createStudentWorld(string assetPath = "");
 
+  // Options:
+  //   --seed N       seed the game's random numbers, to replay the same game
+  //                  (headless, game k is seeded with N+k)
+  // for running without a window:
+  //   --headless     play games with random key presses and report the speed
+  //   --games N      how many games to play headless (default 1)
+  //   --ticks N      stop a headless game after N ticks (default no limit)
+  //   --keyseed N    seed for the random key presses (default 1)
+  // and for running the game with a window as fast as possible:
+  //   --fast [N]     don't wait between ticks; draw only every Nth tick (default 1)
+  // and for recording a game and playing it back:
+  //   --record FILE  save the seed and every key the game read to FILE (one game only)
+  //   --replay FILE  replay FILE without a window as fast as possible, failing if
+  //                  the level files or the game's course differ from the recording
+  // and for timing and checking the world's internals:
+  //   --snapshot-bench  play --ticks ticks (default 1000) of level 0 headless, then time
+  //                  saving and restoring a snapshot of the world against loading the level
+  //   --removal-bench  time removing dead actors from a pea-heavy level 0, before and after
+  //                  removal became one compaction per tick
+  //   --load-bench   time loading and tearing down each level, with actors allocated one
+  //                  by one on the heap and in the level arena
+  //   --draw-order-bench  time finding each depth's objects to draw, by scanning them all
+  //                  per depth and by walking the registry's depth buckets
+  //   --pool-bench   time creating and destroying peas in their pool against new and delete
+  //   --check-dispatch  play a game (seeded by --seed, default 1, and --keyseed, and at most
+  //                  --ticks ticks, default 40000) with actors ticked by type tag and by
+  //                  virtual calls, and check the two games are identical
+  // Any other arguments are passed on to GLUT.
+
+struct Options
+{
+	bool headless = false;
+	int games = 1;
+	long long ticksPerGame = 0;
+	unsigned int keySeed = 1;
+	bool fast = false;
+	int renderEvery = 1;
+	bool seeded = false;
+	unsigned long long seed = 0;
+	string recordFile;
+	string replayFile;
+	bool snapshotBench = false;
+	bool removalBench = false;
+	bool loadBench = false;
+	bool poolBench = false;
+	bool drawOrderBench = false;
+	bool checkDispatch = false;
+};
+
+static bool parseOptions(int& argc, char* argv[], Options& options)
+{
+	int kept = 1;
+	for (int k = 1; k < argc; k++)
+	{
+		string arg = argv[k];
+		bool hasValue = (k + 1 < argc);
+		if (arg == "--headless")
+			options.headless = true;
+		else if (arg == "--snapshot-bench")
+			options.snapshotBench = true;
+		else if (arg == "--removal-bench")
+			options.removalBench = true;
+		else if (arg == "--load-bench")
+			options.loadBench = true;
+		else if (arg == "--pool-bench")
+			options.poolBench = true;
+		else if (arg == "--draw-order-bench")
+			options.drawOrderBench = true;
+		else if (arg == "--check-dispatch")
+			options.checkDispatch = true;
+		else if (arg == "--games" && hasValue)
+			options.games = atoi(argv[++k]);
+		else if (arg == "--ticks" && hasValue)
+			options.ticksPerGame = atoll(argv[++k]);
+		else if (arg == "--fast")
+		{
+			options.fast = true;
+			if (hasValue && isdigit(static_cast<unsigned char>(argv[k+1][0])))
+				options.renderEvery = atoi(argv[++k]);
+		}
+		else if (arg == "--seed" && hasValue)
+		{
+			options.seeded = true;
+			options.seed = strtoull(argv[++k], nullptr, 10);
+		}
+		else if (arg == "--keyseed" && hasValue)
+			options.keySeed = static_cast<unsigned int>(strtoul(argv[++k], nullptr, 10));
+		else if (arg == "--record" && hasValue)
+			options.recordFile = argv[++k];
+		else if (arg == "--replay" && hasValue)
+			options.replayFile = argv[++k];
+		else if (arg == "--games" || arg == "--ticks" || arg == "--keyseed" || arg == "--seed"  ||
+				 arg == "--record" || arg == "--replay")
+		{
+			cout << arg << " needs a value" << endl;
+			return false;
+		}
+		else
+			argv[kept++] = argv[k];
+	}
+	argc = kept;
+	if (!options.recordFile.empty() && options.headless && options.games != 1)
+	{
+		cout << "--record can only record a single game" << endl;
+		return false;
+	}
+	return true;
+}
+
+static int runHeadless(string assetPath, const Options& options, Replay* recording)
+{
+	RandomKeySource keys(options.keySeed);
+	HeadlessDriver driver(&keys, options.ticksPerGame);
+	for (int game = 0; game < options.games; game++)
+	{
+		GameWorld* gw = createStudentWorld(assetPath);
+		if (options.seeded)
+			gw->setRandomSeed(options.seed + game);
+		gw->setKeyRecorder(recording);
+		bool ok = driver.playGame(gw);
+		delete gw;
+		if (!ok)
+		{
+			cout << "Error in level data file encoding!" << endl;
+			return 1;
+		}
+	}
+	driver.report(cout);
+	if (recording != nullptr)
+	{
+		recording->setTicks(driver.lastGameTicks());
+		if (!recording->save(options.recordFile))
+			return 1;
+	}
+	return 0;
+}
+
+static int runReplay(string assetPath, string replayFile)
+{
+	Replay replay;
+	if (!replay.load(replayFile))
+		return 1;
+
+	uint64_t levelHash = Replay::hashLevelFiles(assetPath);
+	if (levelHash != replay.levelHash())
+	{
+		cerr << "***** " << replayFile << " was recorded with different level files (level hash "
+			 << hex << replay.levelHash() << ", but these levels hash to " << levelHash << dec << ")" << endl;
+		return 1;
+	}
+
+	HeadlessDriver driver(&replay, replay.ticks());
+	GameWorld* gw = createStudentWorld(assetPath);
+	gw->setRandomSeed(replay.seed());
+	bool ok = (replay.ticks() == 0 || driver.playGame(gw));
+	delete gw;
+	driver.report(cout);
+
+	  // The same seed, levels, and keys must give the same game; anything else is a bug
+	if (!ok || driver.lastGameTicks() != replay.ticks() || !replay.finished())
+	{
+		cerr << "***** Replay of " << replayFile << " diverged from the recording: it ran "
+			 << driver.lastGameTicks() << " of " << replay.ticks() << " ticks and "
+			 << (replay.finished() ? "read" : "did not read") << " every recorded key" << endl;
+		return 1;
+	}
+	return 0;
+}
+
+  // Play up to ticks ticks with keys from keySeed, stopping early if the level ends
+static int playTicks(GameWorld* gw, long long ticks, unsigned int keySeed)
+{
+	RandomKeySource keys(keySeed);
+	gw->setKeySource(&keys);
+	int status = GWSTATUS_CONTINUE_GAME;
+	for (long long t = 0; t < ticks && status == GWSTATUS_CONTINUE_GAME; t++)
+		status = gw->move();
+	gw->setKeySource(nullptr);
+	return status;
+}
+
+static int runSnapshotBench(string assetPath, const Options& options)
+{
+	using Clock = chrono::steady_clock;
+	const int REPS = 10000;
+	const int LOAD_REPS = 1000;
+
+	GameWorld* gw = createStudentWorld(assetPath);
+	if (options.seeded)
+		gw->setRandomSeed(options.seed);
+	if (gw->init() != GWSTATUS_CONTINUE_GAME)
+	{
+		cout << "Error in level data file encoding!" << endl;
+		delete gw;
+		return 1;
+	}
+
+	  // play a while first, so there are peas and ThiefBots to save, not just the level as loaded
+	playTicks(gw, options.ticksPerGame > 0 ? options.ticksPerGame : 1000, options.keySeed);
+
+	string snapshot;
+	if (!gw->saveSnapshot(snapshot))
+	{
+		cout << "This world doesn't support snapshots" << endl;
+		delete gw;
+		return 1;
+	}
+	size_t objects = GraphObject::getGraphObjects().size();
+
+	string copy;
+	Clock::time_point start = Clock::now();
+	for (int k = 0; k < REPS; k++)
+		gw->saveSnapshot(copy);
+	double saveNs = chrono::duration<double, nano>(Clock::now() - start).count() / REPS;
+
+	start = Clock::now();
+	for (int k = 0; k < REPS; k++)
+		gw->restoreSnapshot(snapshot);
+	double restoreNs = chrono::duration<double, nano>(Clock::now() - start).count() / REPS;
+
+	  // a restored world must save the same bytes, and play on the same way every time
+	bool ok = gw->saveSnapshot(copy) && copy == snapshot;
+	string after[2];
+	for (int run = 0; run < 2; run++)
+	{
+		ok = ok && gw->restoreSnapshot(snapshot);
+		playTicks(gw, 100, options.keySeed + 1);
+		ok = ok && gw->saveSnapshot(after[run]);
+	}
+	ok = ok && after[0] == after[1];
+
+	gw->restoreSnapshot(snapshot);
+	start = Clock::now();
+	for (int k = 0; k < LOAD_REPS; k++)
+	{
+		gw->cleanUp();
+		gw->init();
+	}
+	double loadNs = chrono::duration<double, nano>(Clock::now() - start).count() / LOAD_REPS;
+	gw->cleanUp();
+	delete gw;
+
+	cout << "Snapshot: " << snapshot.size() << " bytes for " << objects << " objects ("
+		 << static_cast<double>(snapshot.size()) / objects << " bytes/object)" << endl;
+	cout << "  save: " << saveNs << "ns (" << saveNs / objects << "ns/object)" << endl;
+	cout << "  restore: " << restoreNs << "ns (" << restoreNs / objects << "ns/object)" << endl;
+	cout << "  loading the level: " << loadNs << "ns" << endl;
+	if (!ok)
+	{
+		cerr << "***** A restored world didn't match its snapshot" << endl;
+		return 1;
+	}
+	return 0;
+}
+
 int main(int argc, char* argv[])
 {
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
     string assetPath = assetDirectory;
     if (!assetPath.empty())
     {
@@ -56,6 +322,52 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	if (!options.replayFile.empty())
+		return runReplay(assetPath, options.replayFile);
+	if (options.snapshotBench)
+		return runSnapshotBench(assetPath, options);
+	if (options.removalBench)
+		return runRemovalBench(assetPath);
+	if (options.loadBench)
+		return runLoadBench(assetPath);
+	if (options.poolBench)
+		return runPoolBench(assetPath);
+	if (options.drawOrderBench)
+		return runDrawOrderBench(assetPath);
+	if (options.checkDispatch)
+		return runDispatchCheck(assetPath, options.seeded ? options.seed : 1, options.keySeed,
+								options.ticksPerGame > 0 ? options.ticksPerGame : 40000);
+
+	  // A recording needs to know the seed, so pick one if none was given
+	Replay recording;
+	if (!options.recordFile.empty())
+	{
+		if (!options.seeded)
+		{
+			random_device rd;
+			options.seed = (static_cast<unsigned long long>(rd()) << 32) | rd();
+			options.seeded = true;
+		}
+		recording.startRecording(options.seed, Replay::hashLevelFiles(assetPath));
+	}
+	Replay* recorder = (options.recordFile.empty() ? nullptr : &recording);
+
+	if (options.headless)
+		return runHeadless(assetPath, options, recorder);
+
+	if (options.fast)
+		Game().setFastForward(options.renderEvery);
+
 	GameWorld* gw = createStudentWorld(assetPath);
+	if (options.seeded)
+		gw->setRandomSeed(options.seed);
+	gw->setKeyRecorder(recorder);
 	Game().run(argc, argv, gw, "Marble Madness", msPerTick);
+
+	if (recorder != nullptr)
+	{
+		recording.setTicks(Game().movesMade());
+		if (!recording.save(options.recordFile))
+			return 1;
+	}
 }